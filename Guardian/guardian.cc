@@ -1,14 +1,38 @@
 #include "SocketManagerUtil/SocketManager.h"
-int main() {
+#include "LogCollectorUtil/LogCollector.h"
+#include "ConfigUtil/ConfigUtil.h"
+#include "ConfigUtil/ConfigWatcher.h"
+int main(int argc, char* argv[]) {
+    // 日志由后台线程批量写入常开的guardian.log;事件循环只负责入队,缓冲区满时丢弃低级别日志而不是等待
+    Logger& logger = Logger::GetInstance();
+    logger.AddHandler(std::make_unique<FileLogHandler>("./guardian.log"));
+    logger.SetOverflowPolicy(OverflowPolicy::DROP_LOW_PRIORITY);
+
+    // 所有服务端进程的日志由此合并写入 servers_YYYY_MM_dd.log;SIGINT/SIGTERM只让事件循环返回,main正常结束后静态对象
+    // 按构造的逆序析构,Logger最先构造、最后析构,其余对象析构时写的日志仍会写入guardian.log
+    static LogCollector collector("./servers");
+    collector.start();
+
+    // 配置文件只在这里解析一次,每次变化都作为新的一代发布到共享内存,服务端直接映射读取
+    ConfigManager::setCommandLine(argc, argv);
+    static SharedConfigPublisher config_publisher;
+    static ConfigWatcher config_watcher("config.conf");
+    config_watcher.subscribe("", [](const ConfigSnapshot& config) {
+        if (config_publisher.publish(config)) {
+            writeLog("Published config generation " + std::to_string(config_publisher.generation()));
+        }
+    });
+    config_watcher.start();
+
     try {
         const char* shm_name = "test_shm";
-        const size_t shm_size = 4096;
+        const size_t shm_size = control::SEGMENT_SIZE;
         const char* server_path = "./Server";
         // 启动 SocketManager 并进入事件循环
         SocketManager& manager = Singleton<SocketManager>::GetInstance(shm_name, shm_size, server_path);
         manager.start();
     } catch (const std::exception& e) {
-        writeLog("Main error: " + std::string(e.what()));
+        writeLog("Main error: " + std::string(e.what()), ERROR);
     }
 
     return 0;
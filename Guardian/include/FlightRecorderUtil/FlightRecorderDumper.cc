@@ -0,0 +1,97 @@
+#include "FlightRecorderUtil/FlightRecorderDumper.h"
+#include "SharedMemoryUtil/SharedMemoryUtil.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+FlightRecorderDumper::FlightRecorderDumper(const std::string& dump_dir, size_t max_bytes)
+    : dump_dir(dump_dir)
+    , max_bytes(max_bytes) {}
+
+void FlightRecorderDumper::discard(pid_t pid) {
+    shm_unlink(flight::SegmentName(pid).c_str());
+}
+
+std::string FlightRecorderDumper::dump(pid_t pid, const std::string& reason) {
+    std::string name = flight::SegmentName(pid);
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd == -1) {
+        if (errno != ENOENT) {
+            writeLog("Failed to open flight recorder " + name + ": " + std::string(strerror(errno)));
+        }
+        return "";
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || static_cast<size_t>(st.st_size) < sizeof(flight::Header)) {
+        close(fd);
+        shm_unlink(name.c_str());
+        return "";
+    }
+    size_t mapped_size = static_cast<size_t>(st.st_size);
+    void* addr = mmap(nullptr, mapped_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        writeLog("Failed to map flight recorder " + name + ": " + std::string(strerror(errno)));
+        shm_unlink(name.c_str());
+        return "";
+    }
+
+    const flight::Header* header = static_cast<const flight::Header*>(addr);
+    std::string path;
+    // 正常退出的进程日志已完整落盘,不需要转储
+    if (flight::Valid(header, mapped_size)
+        && header->state.load(std::memory_order_acquire) != flight::STATE_CLOSED) {
+        uint64_t write_pos = header->write_pos.load(std::memory_order_acquire);
+        uint64_t capacity = header->capacity;
+        uint64_t len = std::min<uint64_t>({write_pos, capacity, max_bytes});
+        uint64_t start = write_pos - len;
+        const char* data = static_cast<const char*>(addr) + header->header_size;
+
+        // 按环形缓冲区的两段拷贝出来
+        std::string tail(len, '\0');
+        size_t offset = static_cast<size_t>(start & (capacity - 1));
+        size_t first = std::min<size_t>(len, capacity - offset);
+        memcpy(&tail[0], data + offset, first);
+        memcpy(&tail[first], data, len - first);
+
+        // 不是从流的开头开始时,第一行可能不完整,丢掉
+        if (start > 0) {
+            size_t newline = tail.find('\n');
+            tail.erase(0, newline == std::string::npos ? tail.size() : newline + 1);
+        }
+
+        char stamp[20];
+        time_t now = time(nullptr);
+        struct tm timeinfo;
+        localtime_r(&now, &timeinfo);
+        strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", &timeinfo);
+        path = dump_dir + "/flight_" + std::to_string(pid) + "_" + stamp + ".log";
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (out.is_open()) {
+            out << "# flight recorder of server pid " << pid << ": " << reason << ", last "
+                << tail.size() << " of " << write_pos << " bytes\n";
+            out.write(tail.data(), static_cast<std::streamsize>(tail.size()));
+        }
+        if (!out.good()) {
+            writeLog("Failed to write flight recorder dump " + path);
+            path.clear();
+        }
+    }
+
+    munmap(addr, mapped_size);
+    shm_unlink(name.c_str());
+    if (!path.empty()) {
+        writeLog("Flight recorder of pid " + std::to_string(pid) + " dumped to " + path);
+    }
+    return path;
+}
@@ -0,0 +1,50 @@
+/**
+ * @file FlightRecorderDumper.h
+ * @author KevinGlaser
+ * @brief Dumps the flight recorder ring a dead server process left in shared memory
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef __FLIGHTRECORDERDUMPER_H__
+#define __FLIGHTRECORDERDUMPER_H__
+
+#include <string>
+
+#include <sys/types.h>
+
+#include "LogUtil/FlightRecorderFormat.h"
+
+class FlightRecorderDumper {
+public:
+    /**
+     * @param dump_dir directory the dump files are written to
+     * @param max_bytes how much of the end of the ring is dumped
+     */
+    explicit FlightRecorderDumper(const std::string& dump_dir = ".", size_t max_bytes = 256 * 1024);
+
+    /**
+     * @brief write the last max_bytes of the ring of a server process that has exited to
+     *        <dump_dir>/flight_<pid>_<time>.log and unlink the segment. Only call this once the
+     *        process is gone, a live writer may be overwriting the data being copied.
+     *
+     * @param pid server process id
+     * @param reason why the process ended, written into the dump header
+     * @return [std::string] path of the dump, empty if there was nothing to dump
+     */
+    std::string dump(pid_t pid, const std::string& reason);
+
+    /**
+     * @brief unlink the segment of pid without dumping it
+     */
+    void discard(pid_t pid);
+
+private:
+    std::string dump_dir;
+    size_t max_bytes;
+};
+
+#endif
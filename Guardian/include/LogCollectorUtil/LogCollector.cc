@@ -0,0 +1,202 @@
+#include "LogCollectorUtil/LogCollector.h"
+#include "SharedMemoryUtil/SharedMemoryUtil.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+#include <poll.h>
+#include <unistd.h>
+
+// 收集线程无数据时的唤醒间隔,用于按时写出到期的记录和驱动文件轮转
+static const int POLL_INTERVAL_MS = 50;
+static const int RECEIVE_BUFFER_SIZE = 4 * 1024 * 1024;
+
+LogCollector::LogCollector(const std::string& base_path, std::chrono::milliseconds reorder_window)
+    : base_path(base_path)
+    , reorder_window(reorder_window)
+    , sock_fd(-1)
+    , running(false)
+    , recv_buffer(64 * 1024) {}
+
+LogCollector::~LogCollector() {
+    stop();
+}
+
+bool LogCollector::start() {
+    sock_fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (sock_fd == -1) {
+        writeLog("Failed to create log collector socket: " + std::string(strerror(errno)), ERROR);
+        return false;
+    }
+
+    sockaddr_un addr;
+    socklen_t addr_len = logship::CollectorAddress(addr);
+    if (bind(sock_fd, reinterpret_cast<const sockaddr*>(&addr), addr_len) == -1) {
+        writeLog("Failed to bind log collector socket: " + std::string(strerror(errno)), ERROR);
+        close(sock_fd);
+        sock_fd = -1;
+        return false;
+    }
+    // 加大接收缓冲区以吸收多个服务端的突发日志
+    setsockopt(sock_fd, SOL_SOCKET, SO_RCVBUF, &RECEIVE_BUFFER_SIZE, sizeof(RECEIVE_BUFFER_SIZE));
+
+    handler = std::make_unique<RotatingFileLogHandler>(base_path);
+    running = true;
+    worker = std::thread(&LogCollector::run, this);
+    writeLog("Log collector listening on @" + std::string(logship::SOCKET_NAME));
+    return true;
+}
+
+void LogCollector::stop() {
+    running = false;
+    if (worker.joinable()) {
+        worker.join();
+    }
+    if (sock_fd != -1) {
+        close(sock_fd);
+        sock_fd = -1;
+    }
+}
+
+void LogCollector::run() {
+    while (running) {
+        pollfd pfd{sock_fd, POLLIN, 0};
+        int ready = poll(&pfd, 1, POLL_INTERVAL_MS);
+        if (ready == -1 && errno != EINTR) {
+            writeLog("Log collector poll() failed: " + std::string(strerror(errno)), ERROR);
+            break;
+        }
+
+        // 一次唤醒把缓冲区中的数据报全部取走
+        while (ready > 0) {
+            ssize_t n = recv(sock_fd, recv_buffer.data(), recv_buffer.size(), MSG_DONTWAIT);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            decodeDatagram(recv_buffer.data(), static_cast<size_t>(n));
+        }
+
+        writeReady(false);
+        handler->OnIdle();
+    }
+
+    // 退出前再取一次,并写出所有暂存的记录
+    ssize_t n;
+    while ((n = recv(sock_fd, recv_buffer.data(), recv_buffer.size(), MSG_DONTWAIT)) > 0) {
+        decodeDatagram(recv_buffer.data(), static_cast<size_t>(n));
+    }
+    writeReady(true);
+    handler->Flush();
+}
+
+void LogCollector::decodeDatagram(const char* data, size_t len) {
+    logship::DatagramHeader header;
+    if (len < sizeof(header)) {
+        return;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != logship::MAGIC || header.version != logship::FORMAT_VERSION
+        || header.header_size < sizeof(header) || header.header_size > len) {
+        return;
+    }
+
+    uint64_t now_ns = binlog::ToNanoseconds(std::chrono::system_clock::now());
+    std::string pid_text = std::to_string(header.pid);
+
+    // 序号不连续说明有数据报在socket缓冲区中被丢弃;序号回到0说明服务端重启(pid被复用)
+    auto it = next_seq.find(header.pid);
+    if (it != next_seq.end() && header.seq > it->second) {
+        addNotice(now_ns, WARN, "server pid " + pid_text + " lost "
+                  + std::to_string(header.seq - it->second) + " datagrams");
+    }
+    if (header.lost_records > 0) {
+        addNotice(now_ns, WARN, "server pid " + pid_text + " could not ship "
+                  + std::to_string(header.lost_records) + " records");
+    }
+    next_seq[header.pid] = header.seq + 1;
+
+    const char* p = data + header.header_size;
+    const char* end = data + len;
+    binlog::DecodedRecord record;
+    for (uint32_t i = 0; i < header.record_count && p < end; ++i) {
+        size_t size = binlog::DecodeRecord(p, end, record);
+        if (size == 0) {
+            addNotice(now_ns, WARN, "malformed datagram from server pid " + pid_text);
+            break;
+        }
+        pending.push_back({record.timestamp_ns, static_cast<LogLevel>(record.level), formatLine(record, header.pid)});
+        p += size;
+    }
+}
+
+void LogCollector::addNotice(uint64_t timestamp_ns, LogLevel level, const std::string& text) {
+    binlog::DecodedRecord record{};
+    record.timestamp_ns = timestamp_ns;
+    record.level = static_cast<uint8_t>(level);
+    record.message = text;
+    pending.push_back({timestamp_ns, level, formatLine(record, static_cast<uint32_t>(getpid()))});
+}
+
+std::string LogCollector::formatLine(const binlog::DecodedRecord& record, uint32_t pid) const {
+    std::time_t seconds = static_cast<std::time_t>(record.timestamp_ns / 1000000000ULL);
+    unsigned millis = static_cast<unsigned>(record.timestamp_ns / 1000000ULL % 1000);
+    std::tm tm;
+    localtime_r(&seconds, &tm);
+    char stamp[32];
+    size_t len = strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm);
+    snprintf(stamp + len, sizeof(stamp) - len, ".%03u", millis);
+
+    std::string line;
+    line.reserve(64 + record.message.size());
+    line.append(stamp).append(" [").append(LogLevelToString(static_cast<LogLevel>(record.level)))
+        .append("] pid:").append(std::to_string(pid)).append(" message:").append(record.message);
+
+    for (const auto& field : record.fields) {
+        line.append(" ").append(field.name).append("=");
+        switch (field.type) {
+            case binlog::FIELD_INT64: line.append(std::to_string(field.i64)); break;
+            case binlog::FIELD_UINT64: line.append(std::to_string(field.u64)); break;
+            case binlog::FIELD_DOUBLE: line.append(std::to_string(field.f64)); break;
+            case binlog::FIELD_BOOL: line.append(field.boolean ? "true" : "false"); break;
+            case binlog::FIELD_STRING: line.append(field.str); break;
+        }
+    }
+    return line;
+}
+
+void LogCollector::writeReady(bool all) {
+    if (pending.empty()) {
+        return;
+    }
+
+    // 各服务端的数据报内部已按时间有序,这里只需把多个来源合并
+    std::stable_sort(pending.begin(), pending.end(), [](const PendingLine& a, const PendingLine& b) {
+        return a.timestamp_ns < b.timestamp_ns;
+    });
+
+    size_t ready = pending.size();
+    if (!all) {
+        uint64_t now_ns = binlog::ToNanoseconds(std::chrono::system_clock::now());
+        uint64_t window_ns = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(reorder_window).count());
+        uint64_t cutoff = now_ns > window_ns ? now_ns - window_ns : 0;
+        ready = static_cast<size_t>(std::upper_bound(pending.begin(), pending.end(), cutoff,
+            [](uint64_t value, const PendingLine& line) { return value < line.timestamp_ns; }) - pending.begin());
+    }
+    if (ready == 0) {
+        return;
+    }
+
+    std::vector<LogRecord> batch(ready);
+    for (size_t i = 0; i < ready; ++i) {
+        batch[i].level = pending[i].level;
+        batch[i].message = std::move(pending[i].text);
+    }
+    handler->HandleBatch(batch);
+    pending.erase(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(ready));
+}
@@ -0,0 +1,81 @@
+/**
+ * @file LogCollector.h
+ * @author KevinGlaser
+ * @brief Receives log records shipped by Server processes and writes them as one ordered, rotated log
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef __LOGCOLLECTOR_H__
+#define __LOGCOLLECTOR_H__
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LogUtil/LogShippingFormat.h"
+#include "LogUtil/RotatingLogHandler.h"
+
+/**
+ * @brief Binds the abstract datagram socket logship::SOCKET_NAME and merges the records of all
+ *        Server processes into <base>_YYYY_MM_dd.log. Records are held for reorder_window and
+ *        written sorted by timestamp, so lines from different processes interleave in time order
+ *        as long as none of them arrives later than the window. The collector thread is the only
+ *        writer of the merged file.
+ */
+class LogCollector {
+public:
+    explicit LogCollector(const std::string& base_path,
+                          std::chrono::milliseconds reorder_window = std::chrono::milliseconds(200));
+    ~LogCollector();
+
+    /**
+     * @brief bind the socket and start the collector thread
+     *
+     * @return true collecting
+     * @return false the socket is already bound by another collector or could not be created
+     */
+    bool start();
+
+    /**
+     * @brief write everything still held and stop the collector thread
+     */
+    void stop();
+
+private:
+    struct PendingLine {
+        uint64_t timestamp_ns;
+        LogLevel level;
+        std::string text;
+    };
+
+    void run();
+    void decodeDatagram(const char* data, size_t len);
+    void addNotice(uint64_t timestamp_ns, LogLevel level, const std::string& text);
+
+    /**
+     * @brief write the held lines older than the reorder window, or all of them
+     */
+    void writeReady(bool all);
+
+    std::string formatLine(const binlog::DecodedRecord& record, uint32_t pid) const;
+
+    std::string base_path;
+    std::chrono::milliseconds reorder_window;
+    int sock_fd;
+    std::atomic<bool> running;
+    std::thread worker;
+    std::unique_ptr<RotatingFileLogHandler> handler;
+    std::vector<PendingLine> pending;
+    std::map<uint32_t, uint64_t> next_seq;     // expected datagram seq per server pid
+    std::vector<char> recv_buffer;
+};
+
+#endif
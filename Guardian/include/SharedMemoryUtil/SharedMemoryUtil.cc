@@ -9,6 +9,10 @@
 #include <unistd.h>
 #endif
 
+void writeLog(const std::string& message, LogLevel level) {
+    Logger::GetInstance().WriteLog(message, level);
+}
+
 bool SharedMemoryManager::createSharedMemory() {
 #ifdef _WIN32
     // Windows shared memory implementation
@@ -59,19 +63,65 @@ bool SharedMemoryManager::createSharedMemory() {
         return false;
     }
 #endif
+    // 上次运行遗留的同名段内容无效,整体清零后重新初始化;magic最后写入
+    memset(shared_data, 0, shm_size);
+    header = reinterpret_cast<control::Header*>(shared_data);
+    control::Initialize(header, shm_size);
     return true;
 }
 
-void SharedMemoryManager::writeData(const std::string& jsonStr) {
-#ifdef _WIN32
-    memcpy_s(shared_data, shm_size, jsonStr.c_str(), jsonStr.length() + 1);  // +1 for null terminator
-#else
-    snprintf(shared_data, shm_size, "%s", jsonStr.c_str());
-#endif
-    writeLog(std::string("set_listening_port_to_shm:[") + shm_name + "][" + jsonStr + "] success");
+bool SharedMemoryManager::publishServerInfo(const std::string& server_id, const std::string& version, unsigned short port) {
+    if (header == nullptr) {
+        return false;
+    }
+    control::ServerInfo info{};
+    info.generation = ++info_generation;
+    info.ready = 1;
+    info.port = port;
+    control::SetField(info.server_id, server_id);
+    control::SetField(info.version, version);
+    {
+        // 顺序锁只允许一个写者
+        std::lock_guard<std::mutex> lock(send_mutex);
+        control::PublishInfo(header->info, info);
+    }
+    writeLog(std::string("set_listening_port_to_shm:[") + shm_name + "][server_id=" + server_id
+             + " version=" + version + " port=" + std::to_string(port) + " generation="
+             + std::to_string(info.generation) + "] success");
+    return true;
+}
+
+void SharedMemoryManager::resetChannel() {
+    if (header == nullptr) {
+        return;
+    }
+    // 此时没有服务端进程,两个环的读写位置都由本进程归零;启动信息保留给新进程
+    std::lock_guard<std::mutex> send_lock(send_mutex);
+    std::lock_guard<std::mutex> receive_lock(receive_mutex);
+    for (control::Ring* ring : {&header->to_server, &header->to_guardian}) {
+        ring->read_pos.store(0, std::memory_order_relaxed);
+        ring->write_pos.store(0, std::memory_order_release);
+    }
+}
+
+bool SharedMemoryManager::sendFrame(const std::string& frame) {
+    std::lock_guard<std::mutex> lock(send_mutex);
+    if (header == nullptr) {
+        return false;
+    }
+    return control::Push(header, header->to_server, frame.data(), static_cast<uint32_t>(frame.size()));
+}
+
+bool SharedMemoryManager::receiveFrame(std::string& frame, int timeout_ms) {
+    std::lock_guard<std::mutex> lock(receive_mutex);
+    if (header == nullptr) {
+        return false;
+    }
+    return control::Receive(header, header->to_guardian, frame, timeout_ms);
 }
 
 void SharedMemoryManager::cleanupSharedMemory() {
+    header = nullptr;
 #ifdef _WIN32
     if (shared_data != nullptr) {
         UnmapViewOfFile(shared_data);
@@ -2,13 +2,13 @@
 #define SHARED_MEMORY_UTIL_H
 
 #include <iostream>
-#include <string>
 #include <mutex>
-#include <fstream>
-#include <ctime>
+#include <string>
 #include <cstring>
 
 #include "JsonUtil/json.hpp"
+#include "LogUtil/LogUtil.h"
+#include "ServerUtil/ControlChannelFormat.h"
 
 #ifdef _WIN32
     #include <windows.h>
@@ -20,36 +20,16 @@
     #include <errno.h>
 #endif
 
-static std::mutex log_mutex;
 using json = nlohmann::json;
 
-static void writeLog(const std::string& message) {
-    // 锁定互斥锁，保证同一时间只有一个线程可以进入临界区
-    std::lock_guard<std::mutex> lock(log_mutex);
-
-    std::ofstream log("./guardian.log", std::ios_base::app);
-    if (log.is_open()) {
-        // 获取当前时间
-        time_t now = time(nullptr);
-        struct tm timeinfo;
-        #ifdef _WIN32
-            localtime_s(&timeinfo, &now);
-        #else
-            localtime_r(&now, &timeinfo);
-        #endif
-
-        // 定义时间格式
-        char buffer[20]; // 确保有足够的空间存储格式化后的时间字符串
-        strftime(buffer, sizeof(buffer), "%Y-%m-%d_%H:%M:%S", &timeinfo);
-
-        // 写入日志文件
-        log << buffer << " " << message << std::endl;
-        log.close();
-    } else {
-        // 如果无法打开日志文件，直接输出到 stderr，并且这里不需要加锁因为这是一个错误路径
-        std::cerr << "Unable to open log file: /home/demo/Documents/Cpp_MultiServer/Guardian/guardian.log" << std::endl;
-    }
-}
+/**
+ * @brief write one line to guardian.log through the asynchronous Logger, the caller only queues
+ *        the record and never waits for file I/O
+ * 
+ * @param message log text
+ * @param level log level, INFO by default
+ */
+void writeLog(const std::string& message, LogLevel level = INFO);
 
 class SharedMemoryManager {
 public:
@@ -63,6 +43,8 @@ public:
             , shm_fd(-1)
             , shared_data(nullptr)
         #endif
+        , header(nullptr)
+        , info_generation(0)
     {
         writeLog("SharedMemoryManager created with name: " + std::string(name));
     }
@@ -72,9 +54,39 @@ public:
     }
 
     bool createSharedMemory();
-    void writeData(const std::string& jsonStr);
     void cleanupSharedMemory();
 
+    /**
+     * @brief publish a new generation of the server's startup information and mark it ready,
+     *        wakes a server waiting for it
+     * 
+     * @param port guardian's listening port
+     * @return false shared memory is not mapped
+     */
+    bool publishServerInfo(const std::string& server_id, const std::string& version, unsigned short port);
+
+    /**
+     * @brief empty both rings, called before a new server process starts
+     * 
+     */
+    void resetChannel();
+
+    /**
+     * @brief queue one frame for the server, wakes it only if it is sleeping on the ring
+     * 
+     * @param frame e.g. control::STOP_COMMAND
+     * @return false shared memory is not mapped or the ring is full
+     */
+    bool sendFrame(const std::string& frame);
+
+    /**
+     * @brief take the next frame the server queued
+     * 
+     * @param timeout_ms -1 waits forever, 0 only checks
+     * @return false timeout or shared memory is not mapped
+     */
+    bool receiveFrame(std::string& frame, int timeout_ms);
+
 private:
     const char* shm_name;
     size_t shm_size;
@@ -86,6 +98,11 @@ private:
         int shm_fd;
         char* shared_data;
     #endif
+    control::Header* header;
+    uint64_t info_generation;
+    // 环只允许一个生产者和一个消费者,本进程内的多个线程在这里排队
+    std::mutex send_mutex;
+    std::mutex receive_mutex;
 };
 
 #endif
\ No newline at end of file
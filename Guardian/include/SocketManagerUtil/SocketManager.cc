@@ -1,5 +1,27 @@
 #include "SocketManager.h"
 
+// 事件循环和心跳路径上的失败日志,每个调用点每个周期最多输出的条数
+static const uint32_t LOG_BURST_LIMIT = 5;
+static const std::chrono::seconds LOG_BURST_INTERVAL(30);
+// 服务端收到停止命令后保存状态的最长等待时间
+static const int STOP_REPLY_TIMEOUT_MS = 5000;
+// 服务端崩溃时先关闭连接、随后才成为僵尸进程,连接断开后最多等这么久再回收
+static const int EXIT_REAP_WAIT_MS = 200;
+
+// 信号处理函数里只做异步信号安全的事: 记下信号,再写管道唤醒事件循环
+static volatile sig_atomic_t stop_signal = 0;
+static int signal_wakeup_fd = -1;
+
+void SocketManager::SocketManagerImpl::signalHandler(int signum) {
+    int saved_errno = errno;
+    stop_signal = signum;
+    if (signal_wakeup_fd != -1) {
+        char byte = 1;
+        ssize_t written = write(signal_wakeup_fd, &byte, 1);
+        (void)written;
+    }
+    errno = saved_errno;
+}
 
 void SocketManager::start() {
     try {
@@ -22,6 +44,7 @@ SocketManager::SocketManagerImpl::SocketManagerImpl(const char* shm_name, const
     , connection_alive(false)
     , server_path(server_path)
     , child_pid(0)
+    , signal_pipe{-1, -1}
     , shm_manager(std::make_unique<SharedMemoryManager>(shm_name, shm_size)) {
         signal(SIGINT, SocketManagerImpl::signalHandler);
         signal(SIGTERM, SocketManagerImpl::signalHandler);
@@ -37,19 +60,9 @@ void SocketManager::SocketManagerImpl::setupListeningSocket() {
         throw std::runtime_error("Failed to create shared memory in file " + std::string(__FILE__) + " at line " + std::to_string(__LINE__));
     }
 
-    json server_info = {
-        {"action", "start_server"},
-        {"msg", 
-            {
-                {"server_id", "server-01"},
-                {"version", "1.0.0"},
-                {"port", longPort},
-            }
-        }
-    };
-
-    std::string json_str = server_info.dump();
-    shm_manager->writeData(json_str);
+    if (!shm_manager->publishServerInfo("server-01", "1.0.0", longPort)) {
+        throw std::runtime_error("Failed to publish server info in file " + std::string(__FILE__) + " at line " + std::to_string(__LINE__));
+    }
 
     // 设置为非阻塞模式
     int flags = fcntl(long_listening_fd, F_GETFL, 0);
@@ -84,13 +97,71 @@ void SocketManager::SocketManagerImpl::initSocketAddr(int& sockfd) {
 }
 
 void SocketManager::SocketManagerImpl::stopChildProcess()  {
-    if (child_pid > 0) {
-        kill(child_pid, SIGTERM);
-        waitpid(child_pid, nullptr, 0);
+    std::lock_guard<std::mutex> lock(child_mtx);
+    pid_t pid = child_pid.load();
+    if (pid > 0) {
+        int status = 0;
+        if (waitpid(pid, &status, WNOHANG) != pid) {
+            // 先通过共享内存请求服务端保存状态后退出,超时没有回应再发SIGTERM
+            bool stopped = false;
+            if (shm_manager->sendFrame(control::STOP_COMMAND)) {
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(STOP_REPLY_TIMEOUT_MS);
+                std::string frame;
+                while (!stopped) {
+                    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        deadline - std::chrono::steady_clock::now()).count();
+                    if (left <= 0 || !shm_manager->receiveFrame(frame, static_cast<int>(left))) {
+                        break;
+                    }
+                    // 回应之前排队的其他消息照常记录
+                    stopped = frame == control::STOPPED_REPLY || frame == control::STOPPED_EXCEPTION_REPLY;
+                    writeLog("Server: " + frame);
+                }
+            }
+            if (!stopped) {
+                writeLog("Server did not answer the stop request, sending SIGTERM", WARN);
+                kill(pid, SIGTERM);
+            }
+            waitpid(pid, &status, 0);
+        }
+        child_pid.store(0);
         writeLog("Child process stopped.");
+        // 正常退出时服务端已标记飞行记录器为关闭,只有异常结束才会生成转储
+        flight_recorder.dump(pid, describeExit(status));
     }
 }
 
+bool SocketManager::SocketManagerImpl::reapExitedChild(int wait_ms) {
+    std::lock_guard<std::mutex> lock(child_mtx);
+    pid_t pid = child_pid.load();
+    if (pid <= 0) {
+        return false;
+    }
+    int status = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(wait_ms);
+    pid_t reaped;
+    while ((reaped = waitpid(pid, &status, WNOHANG)) == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (reaped != pid) {
+        return false;
+    }
+    child_pid.store(0);
+    writeLog("Server process " + std::to_string(pid) + " " + describeExit(status));
+    flight_recorder.dump(pid, describeExit(status));
+    return true;
+}
+
+std::string SocketManager::SocketManagerImpl::describeExit(int status) {
+    if (WIFSIGNALED(status)) {
+        return "killed by signal " + std::to_string(WTERMSIG(status)) + " (" + strsignal(WTERMSIG(status)) + ")";
+    }
+    if (WIFEXITED(status)) {
+        return "exited with status " + std::to_string(WEXITSTATUS(status));
+    }
+    return "ended with wait status " + std::to_string(status);
+}
+
 unsigned short SocketManager::SocketManagerImpl::getLocalPort(int sockfd) {
     struct sockaddr_in sockAddr;
     socklen_t nlen = sizeof(sockAddr);
@@ -112,14 +183,25 @@ void SocketManager::SocketManagerImpl::setupEpoll() {
         close(_epoll_fd);
         throw std::runtime_error("epoll_ctl() failed in file " + std::string(__FILE__) + " at line " + std::to_string(__LINE__));
     }
+
+    // SIGINT/SIGTERM可能落在任意线程上,通过管道让阻塞在epoll_wait的事件循环醒来
+    if (pipe2(signal_pipe, O_NONBLOCK | O_CLOEXEC) == -1) {
+        throw std::runtime_error("pipe2() failed in file " + std::string(__FILE__) + " at line " + std::to_string(__LINE__));
+    }
+    event.events = EPOLLIN;
+    event.data.fd = signal_pipe[0];
+    if (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, signal_pipe[0], &event) == -1) {
+        throw std::runtime_error("epoll_ctl() failed in file " + std::string(__FILE__) + " at line " + std::to_string(__LINE__));
+    }
+    signal_wakeup_fd = signal_pipe[1];
 }
 
 void SocketManager::SocketManagerImpl::sendMessage(const std::string& message) {
-    ssize_t sent_bytes = send(server_fds, message.c_str(), message.size(), 0);
-    if (sent_bytes == -1) {
-        writeLog("Failed to send message to client with fd: " + std::to_string(server_fds));
+    if (!framing::SendFrame(server_fds, message)) {
+        LOG_RATE_LIMITED(ERROR, LOG_BURST_LIMIT, LOG_BURST_INTERVAL,
+                         "Failed to send message to client with fd: " << server_fds << ": " << strerror(errno));
     } else {
-        writeLog("Message sent to client with fd: " + std::to_string(server_fds));
+        LOG_DEDUP(DEBUG, "Message sent to client with fd: " << server_fds);
     }
 }
 
@@ -127,7 +209,8 @@ void SocketManager::SocketManagerImpl::handleEvents() {
     const int MAX_EVENTS = 1;
     struct epoll_event events[MAX_EVENTS];
 
-    while (true) {
+    // 收到停止信号后返回,main正常结束,服务端在静态对象析构时按正常流程停止
+    while (stop_signal == 0) {
         int nfds = epoll_wait(_epoll_fd, events, MAX_EVENTS, -1);
         if (nfds == -1) {
             if (errno != EINTR) { // 如果不是被信号中断，则抛出异常
@@ -137,6 +220,9 @@ void SocketManager::SocketManagerImpl::handleEvents() {
         }
 
         for (int i = 0; i < nfds; ++i) {
+            if (events[i].data.fd == signal_pipe[0]) {
+                continue;
+            }
             if (events[i].data.fd == long_listening_fd) {
                 // 接受新连接
                 struct sockaddr_in clientAddr;
@@ -162,41 +248,67 @@ void SocketManager::SocketManagerImpl::handleEvents() {
                     close(connfd);
                     throw std::runtime_error("epoll_ctl() failed in file " + std::string(__FILE__) + " at line " + std::to_string(__LINE__));
                 }
+                // 超时监控关闭的连接没有经过closeConnection,复用的fd不能带着旧连接的残留数据
+                decoders[connfd].Reset();
                 server_fds = connfd;
                 writeLog("New connection established.");
             } else {
                 // 处理服务端请求
-                int fd = events[i].data.fd;
-                char buffer[1024];
-                ssize_t numBytes = read(fd, buffer, sizeof(buffer) - 1);
-                if (numBytes <= 0) {
-                    if (numBytes == 0 || (numBytes == -1 && (errno == ECONNRESET))) {
-                        // 连接关闭或重置
-                        close(fd);
-                        epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
-                        writeLog("Connection closed.");
-                        connection_alive = false;
-                    } else {
-                        // 其他读取错误
-                        close(fd);
-                        epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
-                        throw std::runtime_error("read() failed");
-                    }
-                } else {
-                    buffer[numBytes] = '\0';
-                    writeLog("Received data from server: " + std::string(buffer));
-                    // 解析 JSON 消息
-                    try {
-                        json j = json::parse(buffer);
-                        handleAction(j["action"], j["msg"]);
-                    } catch (const json::parse_error& e) {
-                        writeLog("Failed to parse JSON message: " + std::string(e.what()));
-                    }
+                handleServerData(events[i].data.fd);
+            }
+        }
+    }
+}
+
+void SocketManager::SocketManagerImpl::handleServerData(int fd) {
+    framing::Decoder& decoder = decoders[fd];
+    std::string payload;
+    while (true) {
+        framing::ReadStatus status = framing::ReadSome(fd, decoder);
+        if (status == framing::ReadStatus::WOULD_BLOCK) {
+            // 边沿触发,读到EAGAIN才算取完
+            return;
+        }
+        if (status == framing::ReadStatus::DATA) {
+            while (decoder.Next(payload)) {
+                LOG_DEDUP(INFO, "Received data from server: " << payload);
+                // 解析 JSON 消息
+                try {
+                    json j = json::parse(payload);
+                    handleAction(j["action"], j["msg"]);
+                } catch (const json::exception& e) {
+                    LOG_RATE_LIMITED(ERROR, LOG_BURST_LIMIT, LOG_BURST_INTERVAL,
+                                     "Failed to parse JSON message: " << e.what());
                 }
             }
+            if (!decoder.Failed()) {
+                continue;
+            }
+            LOG_RATE_LIMITED(ERROR, LOG_BURST_LIMIT, LOG_BURST_INTERVAL,
+                             "Oversized frame from server, closing connection with fd: " << fd);
+            closeConnection(fd);
+            return;
+        }
+        if (status == framing::ReadStatus::ERROR && errno != ECONNRESET) {
+            // 其他读取错误
+            closeConnection(fd);
+            throw std::runtime_error("read() failed");
         }
-        // 添加日志记录以确保持续读取消息
-        sleep(1);
+        // 连接关闭或重置
+        closeConnection(fd);
+        LOG_DEDUP(WARN, "Connection closed.");
+        // 服务端崩溃时连接随之关闭,稍等它退出完毕再转储飞行记录器;仍在运行则交给监控线程
+        reapExitedChild(EXIT_REAP_WAIT_MS);
+        return;
+    }
+}
+
+void SocketManager::SocketManagerImpl::closeConnection(int fd) {
+    epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    decoders.erase(fd);
+    if (fd == server_fds) {
+        connection_alive = false;
     }
 }
 
@@ -235,9 +347,7 @@ void SocketManager::SocketManagerImpl::handleStart(const std::string& msg) {
         sendMessage(response.dump());
         writeLog("Startup confirmation sent");
         
-        // 清理共享内存并启动心跳监控
-        writeLog("Shared memory will be closed to save memory");
-        shm_manager->cleanupSharedMemory();
+        // 共享内存保持映射,之后的停止命令经由其中的控制通道发送
         initializeConnectionMonitor();
     }
 }
@@ -248,6 +358,8 @@ void SocketManager::SocketManagerImpl::handleStop(const std::string& msg) {
 }
 
 void SocketManager::SocketManagerImpl::startChildProcess() {
+    // 上一个服务端进程遗留的命令和回应不能被新进程看到
+    shm_manager->resetChannel();
     pid_t pid = fork();
     if (pid == -1) {
         writeLog("Failed to fork process: " + std::string(strerror(errno)));
@@ -255,14 +367,20 @@ void SocketManager::SocketManagerImpl::startChildProcess() {
     } else if (pid == 0) {
         // 子进程
         execl(server_path, "server", (char*)NULL);
-        writeLog("Failed to execute server: " + std::string(strerror(errno)));
-        exit(1);
+        // 子进程里没有日志线程,也不能运行父进程的静态析构(它们会join父进程的线程),直接写stderr并_exit
+        const char* reason = strerror(errno);
+        const char prefix[] = "Failed to execute server: ";
+        ssize_t ignored = write(STDERR_FILENO, prefix, sizeof(prefix) - 1);
+        ignored = write(STDERR_FILENO, reason, strlen(reason));
+        ignored = write(STDERR_FILENO, "\n", 1);
+        (void)ignored;
+        _exit(127);
     } else {
-        child_pid = pid;
+        child_pid.store(pid);
         writeLog("Parent process continues.");
         
         // 创建服务器监控实例并启动监控
-        server_monitor = std::make_unique<ServerMonitor>(child_pid);
+        server_monitor = std::make_unique<ServerMonitor>(pid);
         startProcessMonitoring();
     }
 }
@@ -275,7 +393,7 @@ void SocketManager::SocketManagerImpl::handleHeartbeatRequest() {
         {"msg", "pong"}
     };
     sendMessage(response.dump());
-    writeLog("Heartbeat response sent");
+    LOG_DEDUP(DEBUG, "Heartbeat response sent");
 }
 
 // 简化启动心跳监控的函数
@@ -312,27 +430,31 @@ void SocketManager::SocketManagerImpl::startProcessMonitoring() {
             
             auto status = server_monitor->checkServerStatus();
             if (!server_monitor->isHealthy()) {
-                writeLog("Server health check failed: " + server_monitor->getStatusReport());
+                LOG_RATE_LIMITED(WARN, LOG_BURST_LIMIT, LOG_BURST_INTERVAL,
+                                 "Server health check failed: " << server_monitor->getStatusReport());
                 
                 // 如果检测到死锁或严重的性能问题
                 if (status.is_deadlocked || 
                     status.cpu_usage > 95 || 
                     status.memory_usage > 95) {
                     writeLog("Critical server condition detected, initiating restart...");
+                    // stopChildProcess在重启前转储飞行记录器
                     stopChildProcess();
                     startChildProcess();
                     return;  // 退出当前监控线程
                 }
             }
         }
+        reapExitedChild();
     }).detach();
 }
 
 bool SocketManager::SocketManagerImpl::isServerRunning() const {
-    if (child_pid <= 0) return false;
+    pid_t pid = child_pid.load();
+    if (pid <= 0) return false;
     
     // 检查进程是否存在
-    if (kill(child_pid, 0) == -1 && errno == ESRCH) {
+    if (kill(pid, 0) == -1 && errno == ESRCH) {
         return false;
     }
     
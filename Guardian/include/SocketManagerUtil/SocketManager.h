@@ -8,6 +8,8 @@
 #include <memory>
 #include <mutex>
 #include <chrono>
+#include <atomic>
+#include <unordered_map>
 
 #ifdef _WIN32
     #include <winsock2.h>
@@ -28,7 +30,9 @@
 #endif
 
 #include "SharedMemoryUtil/SharedMemoryUtil.h"
+#include "ServerUtil/FrameCodec.h"
 #include "ProcessMonitorUtil/ServerMonitor.h"
+#include "FlightRecorderUtil/FlightRecorderDumper.h"
 #include "SingletonBase/Singleton.h"
 #include "JsonUtil/json.hpp"
 
@@ -82,6 +86,11 @@ public:
         }
         #endif
         stopChildProcess();
+        for (int fd : signal_pipe) {
+            if (fd != -1) {
+                close(fd);
+            }
+        }
     }
 
     /**
@@ -91,11 +100,12 @@ public:
     void stopChildProcess();
 
     /**
-     * @brief handle signal from terminal or others,such as [kill -9] 
+     * @brief handle SIGINT/SIGTERM: remember the signal and wake handleEvents(), which then returns
+     *        so the server is stopped by the normal destructors instead of inside the handler
      * 
      * @param signum 
      */
-    static void signalHandler(int signum) { exit(signum); }
+    static void signalHandler(int signum);
 
     /**
      * @brief initialize listening socket and write socket port into shared memory
@@ -130,6 +140,21 @@ public:
      */
     void handleEvents();
 
+    /**
+     * @brief read everything the server sent on fd until EAGAIN and handle every complete message,
+     *        the connection is edge triggered
+     * 
+     * @param fd connection from the server process
+     */
+    void handleServerData(int fd);
+
+    /**
+     * @brief close a server connection and drop its buffered input
+     * 
+     * @param fd connection from the server process
+     */
+    void closeConnection(int fd);
+
     /**
      * @brief start child process
      * 
@@ -173,6 +198,23 @@ public:
      */
     void sendMessage(const std::string& msg);
 
+    /**
+     * @brief reap the server process if it has exited and dump its flight recorder; called by the
+     *        event loop when the connection closes and by the process monitor thread
+     * 
+     * @param wait_ms how long to wait for the process to finish exiting, 0 only checks
+     * @return true the process was reaped
+     */
+    bool reapExitedChild(int wait_ms = 0);
+
+    /**
+     * @brief describe a waitpid() status for the flight recorder dump
+     * 
+     * @param status status from waitpid()
+     * @return [std::string] 
+     */
+    static std::string describeExit(int status);
+
     /**
      * @brief initialize connection monitor, watch the heartbeat status
      * 
@@ -188,9 +230,16 @@ private:
     std::time_t last_heartbeat_time;
     bool connection_alive;
     const char* server_path;
-    pid_t child_pid;
+    // 事件循环、进程监控线程和析构都会读取;回收和转储在child_mtx下进行,同一进程只处理一次
+    std::atomic<pid_t> child_pid;
+    std::mutex child_mtx;
+    // 信号处理函数写入一个字节唤醒事件循环
+    int signal_pipe[2];
     std::unique_ptr<SharedMemoryManager> shm_manager;
+    // 每个连接一个解码器,读到的半条消息留到下次可读时拼接
+    std::unordered_map<int, framing::Decoder> decoders;
     std::unique_ptr<ServerMonitor> server_monitor;
+    FlightRecorderDumper flight_recorder;
     
     void handleHeartbeatRequest();
     bool isConnectionTimedOut() const;
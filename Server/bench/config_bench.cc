@@ -0,0 +1,261 @@
+/**
+ * @file config_bench.cc
+ * @author KevinGlaser
+ * @brief Cold start load time of a large config file, parsing the INI text versus mapping the
+ *        image compiled by ConfigManager::compileConfig
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * usage: config_bench [--sections N] [--keys N] [--runs N] [--dir DIR]
+ *        Writes a config of N sections with N keys each, then loads it --runs times per mode, every
+ *        load in a forked child so it is the process's first ConfigManager call. The cold modes
+ *        drop the files from the page cache with posix_fadvise before each run, the warm modes
+ *        leave them cached. Every child returns a checksum of the loaded values, parse and binary
+ *        loads must agree.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "ConfigUtil/ConfigUtil.h"
+#include "ConfigUtil/ConfigImage.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchOptions {
+    unsigned sections = 200;
+    unsigned keys = 100;
+    unsigned runs = 20;
+    std::string dir;
+};
+
+// 子进程通过管道回传给父进程的结果
+struct LoadResult {
+    uint64_t load_ns;
+    uint64_t entries;           // 来自配置文件的条目数
+    uint64_t fingerprint;
+    bool ok;
+};
+
+// 键按非字典序写出,与手写的配置文件一样需要排序
+static std::string makeConfig(const BenchOptions& options) {
+    std::string text = "# generated by config_bench\n";
+    for (unsigned s = 0; s < options.sections; ++s) {
+        unsigned section = (s * 7919u) % options.sections;
+        text.append("[Section").append(std::to_string(section)).append("]\n");
+        for (unsigned k = 0; k < options.keys; ++k) {
+            unsigned key = (k * 104729u) % options.keys;
+            text.append("key_").append(std::to_string(key)).append("=value of key ")
+                .append(std::to_string(key)).append(" in section ").append(std::to_string(section)).append("\n");
+        }
+        text.append("\n");
+    }
+    return text;
+}
+
+static bool writeText(const std::string& path, const std::string& text) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        return false;
+    }
+    bool ok = write(fd, text.data(), text.size()) == static_cast<ssize_t>(text.size()) && fsync(fd) == 0;
+    close(fd);
+    return ok;
+}
+
+// 让内核丢弃文件的干净页,下一次读取需要重新从磁盘读入
+static void dropCache(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd != -1) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+static LoadResult loadInChild(const std::string& path) {
+    LoadResult result{};
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return result;
+    }
+    std::cout << std::flush;
+
+    pid_t pid = fork();
+    if (pid == -1) {
+        close(fds[0]);
+        close(fds[1]);
+        return result;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        LoadResult child{};
+        try {
+            auto begin = Clock::now();
+            auto snapshot = ConfigManager::getSnapshot(path);
+            child.load_ns = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count());
+            std::string values;
+            for (const auto& entry : snapshot->entries()) {
+                // 默认值等其他来源的条目不计入
+                if (entry.source == ConfigSource::FILE) {
+                    ++child.entries;
+                }
+                values.append(entry.section).append("\n").append(entry.key).append("\n")
+                    .append(entry.value).append("\n");
+            }
+            child.fingerprint = configimage::Checksum(values.data(), values.size());
+            child.ok = true;
+        } catch (const std::exception& e) {
+            std::cerr << "load failed: " << e.what() << std::endl;
+        }
+        ssize_t n = write(fds[1], &child, sizeof(child));
+        close(fds[1]);
+        _exit(n == static_cast<ssize_t>(sizeof(child)) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    ssize_t n = read(fds[0], &result, sizeof(result));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (n != static_cast<ssize_t>(sizeof(result))) {
+        result.ok = false;
+    }
+    return result;
+}
+
+static void printUsage() {
+    std::cerr << "usage: config_bench [--sections N] [--keys N] [--runs N] [--dir DIR]" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+        std::string value = argv[++i];
+        if (arg == "--sections") {
+            options.sections = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (arg == "--keys") {
+            options.keys = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (arg == "--runs") {
+            options.runs = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (arg == "--dir") {
+            options.dir = value;
+        } else {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+    if (options.sections == 0 || options.keys == 0 || options.runs == 0) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    // 默认把配置写到临时目录,结束后删除
+    bool own_dir = options.dir.empty();
+    if (own_dir) {
+        char tmpl[] = "/tmp/config_bench.XXXXXX";
+        if (mkdtemp(tmpl) == nullptr) {
+            std::cerr << "Failed to create temporary directory: " << strerror(errno) << std::endl;
+            return EXIT_FAILURE;
+        }
+        options.dir = tmpl;
+    }
+    // 绝对路径,ConfigManager不会再拼接可执行文件所在目录
+    std::string path = std::filesystem::absolute(options.dir + "/bench.conf").string();
+    std::string image = path + ".bin";
+
+    if (!writeText(path, makeConfig(options))) {
+        std::cerr << "Failed to write " << path << ": " << strerror(errno) << std::endl;
+        return EXIT_FAILURE;
+    }
+    auto compile_begin = Clock::now();
+    bool compiled = ConfigManager::compileConfig(path);
+    auto compile_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - compile_begin).count();
+    if (!compiled) {
+        std::cerr << "Failed to compile " << path << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::error_code ec;
+    std::cout << options.sections * options.keys << " keys, text " << std::filesystem::file_size(path, ec)
+              << " bytes, image " << std::filesystem::file_size(image, ec) << " bytes, compiled in "
+              << std::fixed << std::setprecision(2) << compile_ns / 1e6 << " ms" << std::endl;
+    std::cout << std::left << std::setw(14) << "mode" << std::right << std::setw(12) << "min ms"
+              << std::setw(12) << "median ms" << std::setw(12) << "max ms" << std::endl;
+
+    struct Mode {
+        const char* name;
+        bool binary;
+        bool cold;
+    };
+    const Mode modes[] = {
+        {"parse cold", false, true},
+        {"binary cold", true, true},
+        {"parse warm", false, false},
+        {"binary warm", true, false},
+    };
+
+    int failures = 0;
+    uint64_t expected_fingerprint = 0;
+    for (const auto& mode : modes) {
+        // 解析模式删除镜像,二进制模式保留镜像
+        std::string moved = image + ".keep";
+        if (!mode.binary) {
+            std::filesystem::rename(image, moved, ec);
+        }
+
+        std::vector<uint64_t> samples;
+        for (unsigned run = 0; run < options.runs; ++run) {
+            if (mode.cold) {
+                dropCache(path);
+                dropCache(image);
+            }
+            LoadResult result = loadInChild(path);
+            if (!result.ok || result.entries != uint64_t(options.sections) * options.keys) {
+                ++failures;
+                continue;
+            }
+            if (expected_fingerprint == 0) {
+                expected_fingerprint = result.fingerprint;
+            } else if (result.fingerprint != expected_fingerprint) {
+                std::cerr << mode.name << ": loaded values differ from the first load" << std::endl;
+                ++failures;
+            }
+            samples.push_back(result.load_ns);
+        }
+
+        if (!mode.binary) {
+            std::filesystem::rename(moved, image, ec);
+        }
+        if (samples.empty()) {
+            std::cout << std::left << std::setw(14) << mode.name << std::right << "  failed" << std::endl;
+            continue;
+        }
+        std::sort(samples.begin(), samples.end());
+        std::cout << std::left << std::setw(14) << mode.name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(12) << samples.front() / 1e6 << std::setw(12) << samples[samples.size() / 2] / 1e6
+                  << std::setw(12) << samples.back() / 1e6 << std::endl;
+    }
+
+    if (own_dir) {
+        std::filesystem::remove_all(options.dir, ec);
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,373 @@
+/**
+ * @file logger_bench.cc
+ * @author KevinGlaser
+ * @brief Throughput, latency and memory benchmark of Logger across thread counts and handler types
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * usage: logger_bench [--threads 1,2,4,...] [--sinks null,terminal,...] [--messages N]
+ *                     [--policy block|drop|sample] [--dir DIR]
+ *        --messages is the total number of WriteLog calls per run, split across the threads.
+ *        Each (sink, threads) pair runs in a forked child so every run starts with a fresh Logger
+ *        and its own memory figures. The child's stdout is redirected to /dev/null, so the
+ *        terminal sink measures formatting and iostream cost without a real tty.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "LogUtil/LogUtil.h"
+#include "LogUtil/RotatingLogHandler.h"
+#include "LogUtil/MmapLogHandler.h"
+#include "LogUtil/BinaryLogHandler.h"
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchOptions {
+    std::vector<unsigned> threads = {1, 2, 4, 8, 16, 32, 64};
+    std::vector<std::string> sinks = {"null", "terminal", "file", "rotating", "mmap", "binary"};
+    uint64_t messages = 1000000;
+    OverflowPolicy policy = OverflowPolicy::BLOCK;
+    std::string dir;
+};
+
+// 子进程通过管道回传给父进程的结果
+struct BenchResult {
+    uint64_t calls;
+    uint64_t handled;
+    uint64_t dropped;
+    double ns_per_call;
+    double lines_per_sec;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+    uint64_t max_ns;
+    long rss_growth_kb;
+    long peak_growth_kb;
+    bool ok;
+};
+
+// 不做任何输出的handler,只衡量日志管线本身
+class NullLogHandler : public LogHandler {
+public:
+    void HandleLog(const std::string&, LogLevel) override {}
+    void HandleBatch(const std::vector<LogRecord>&) override {}
+    bool NeedsFormattedText() const override { return false; }
+};
+
+// 统计被测handler实际处理的记录数,用来判断吞吐测量何时结束
+class CountingLogHandler : public LogHandler {
+public:
+    CountingLogHandler(std::unique_ptr<LogHandler> inner, std::atomic<uint64_t>& counter)
+        : inner_(std::move(inner)), counter_(counter) {}
+
+    void HandleLog(const std::string& message, LogLevel level) override {
+        inner_->HandleLog(message, level);
+        counter_.fetch_add(1, std::memory_order_relaxed);
+    }
+    void HandleBatch(const std::vector<LogRecord>& batch) override {
+        inner_->HandleBatch(batch);
+        counter_.fetch_add(batch.size(), std::memory_order_relaxed);
+    }
+    void OnIdle() override { inner_->OnIdle(); }
+    void Flush() override { inner_->Flush(); }
+    bool NeedsFormattedText() const override { return inner_->NeedsFormattedText(); }
+
+private:
+    std::unique_ptr<LogHandler> inner_;
+    std::atomic<uint64_t>& counter_;
+};
+
+static std::unique_ptr<LogHandler> makeSink(const std::string& sink, const std::string& dir) {
+    if (sink == "null") {
+        return std::make_unique<NullLogHandler>();
+    } else if (sink == "terminal") {
+        return std::make_unique<TerminalLogHandler>();
+    } else if (sink == "file") {
+        return std::make_unique<FileLogHandler>(dir + "/bench.log");
+    } else if (sink == "rotating") {
+        return std::make_unique<RotatingFileLogHandler>(dir + "/bench");
+    } else if (sink == "mmap") {
+        return std::make_unique<MmapLogHandler>(dir + "/bench_mmap");
+    } else if (sink == "binary") {
+        return std::make_unique<BinaryLogHandler>(dir + "/bench_binary");
+    }
+    return nullptr;
+}
+
+// /proc/self/status中的VmRSS和VmHWM,单位KB
+static long readStatusKb(const char* key) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    size_t key_len = strlen(key);
+    while (std::getline(status, line)) {
+        if (line.compare(0, key_len, key) == 0) {
+            return std::strtol(line.c_str() + key_len + 1, nullptr, 10);
+        }
+    }
+    return 0;
+}
+
+static uint64_t percentile(const std::vector<uint32_t>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+    return sorted[index];
+}
+
+static BenchResult runBench(const std::string& sink, unsigned threads, const BenchOptions& options) {
+    BenchResult result{};
+    std::atomic<uint64_t> handled{0};
+
+    Logger& logger = Logger::GetInstance();
+    logger.SetOverflowPolicy(options.policy);
+    std::unique_ptr<LogHandler> handler = makeSink(sink, options.dir);
+    if (!handler) {
+        return result;
+    }
+    logger.AddHandler(std::make_unique<CountingLogHandler>(std::move(handler), handled));
+
+    uint64_t per_thread = options.messages / threads;
+    std::vector<std::vector<uint32_t>> latencies(threads);
+    std::vector<uint64_t> busy_ns(threads, 0);
+    // 预先分配并触碰延迟样本的内存,不计入突发写入的内存增长
+    for (auto& samples : latencies) {
+        samples.assign(per_thread, 0);
+    }
+
+    // 预热:让日志线程和缓冲区就绪,不计入结果
+    logger.WriteLog("logger_bench warm up", INFO);
+    while (handled.load(std::memory_order_relaxed) == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    uint64_t base_handled = handled.load();
+    uint64_t base_dropped = logger.DroppedCount();
+    long base_rss = readStatusKb("VmRSS:");
+    long base_peak = readStatusKb("VmHWM:");
+
+    std::atomic<unsigned> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            std::string message = "logger_bench thread " + std::to_string(t) + " writes a line of typical length";
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            auto begin = Clock::now();
+            for (uint64_t i = 0; i < per_thread; ++i) {
+                auto call_begin = Clock::now();
+                logger.WriteLog(message, INFO);
+                auto call_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - call_begin).count();
+                latencies[t][i] = static_cast<uint32_t>(std::min<int64_t>(call_ns, UINT32_MAX));
+            }
+            busy_ns[t] = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count());
+        });
+    }
+    while (ready.load() < threads) {
+        std::this_thread::yield();
+    }
+
+    auto start = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    long burst_rss = readStatusKb("VmRSS:");
+    long burst_peak = readStatusKb("VmHWM:");
+
+    // 等待日志线程把所有记录交给handler,被丢弃的记录也算处理完毕
+    uint64_t expected = per_thread * threads;
+    auto deadline = Clock::now() + std::chrono::seconds(120);
+    while (Clock::now() < deadline) {
+        uint64_t done = (handled.load() - base_handled) + (logger.DroppedCount() - base_dropped);
+        if (done >= expected) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    double elapsed_s = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<uint32_t> all;
+    all.reserve(expected);
+    uint64_t total_busy = 0;
+    for (unsigned t = 0; t < threads; ++t) {
+        all.insert(all.end(), latencies[t].begin(), latencies[t].end());
+        total_busy += busy_ns[t];
+    }
+    std::sort(all.begin(), all.end());
+
+    result.calls = expected;
+    result.dropped = logger.DroppedCount() - base_dropped;
+    // 丢弃报告本身也是一条记录,不计入
+    result.handled = std::min(handled.load() - base_handled, expected);
+    result.ns_per_call = expected ? static_cast<double>(total_busy) / static_cast<double>(expected) : 0;
+    result.lines_per_sec = elapsed_s > 0 ? static_cast<double>(result.handled) / elapsed_s : 0;
+    result.p50_ns = percentile(all, 0.50);
+    result.p99_ns = percentile(all, 0.99);
+    result.p999_ns = percentile(all, 0.999);
+    result.max_ns = all.empty() ? 0 : all.back();
+    result.rss_growth_kb = burst_rss - base_rss;
+    result.peak_growth_kb = burst_peak - base_peak;
+    result.ok = (result.handled + result.dropped >= expected);
+    return result;
+}
+
+static bool runInChild(const std::string& sink, unsigned threads, const BenchOptions& options, BenchResult& result) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return false;
+    }
+    std::cout << std::flush;
+
+    pid_t pid = fork();
+    if (pid == -1) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        int devnull = open("/dev/null", O_WRONLY);
+        if (devnull != -1) {
+            dup2(devnull, STDOUT_FILENO);
+            close(devnull);
+        }
+        BenchResult child_result = runBench(sink, threads, options);
+        ssize_t n = write(fds[1], &child_result, sizeof(child_result));
+        close(fds[1]);
+        // Logger单例的析构会等待剩余日志写完,这里跳过以免拖慢下一组测试
+        _exit(n == static_cast<ssize_t>(sizeof(child_result)) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    ssize_t n = read(fds[0], &result, sizeof(result));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return n == static_cast<ssize_t>(sizeof(result)) && result.ok;
+}
+
+template<typename T>
+static std::vector<T> splitList(const std::string& text) {
+    std::vector<T> values;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) {
+            continue;
+        }
+        std::stringstream conv(item);
+        T value{};
+        conv >> value;
+        values.push_back(value);
+    }
+    return values;
+}
+
+static void printUsage() {
+    std::cerr << "usage: logger_bench [--threads 1,2,4,...] [--sinks null,terminal,file,rotating,mmap,binary]\n"
+                 "                    [--messages N] [--policy block|drop|sample] [--dir DIR]" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+        std::string value = argv[++i];
+        if (arg == "--threads") {
+            options.threads = splitList<unsigned>(value);
+        } else if (arg == "--sinks") {
+            options.sinks = splitList<std::string>(value);
+        } else if (arg == "--messages") {
+            options.messages = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--policy") {
+            if (value == "block") {
+                options.policy = OverflowPolicy::BLOCK;
+            } else if (value == "drop") {
+                options.policy = OverflowPolicy::DROP_LOW_PRIORITY;
+            } else if (value == "sample") {
+                options.policy = OverflowPolicy::SAMPLE;
+            } else {
+                printUsage();
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--dir") {
+            options.dir = value;
+        } else {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    // 默认把日志文件写到临时目录,结束后删除
+    bool own_dir = options.dir.empty();
+    if (own_dir) {
+        char tmpl[] = "/tmp/logger_bench.XXXXXX";
+        if (mkdtemp(tmpl) == nullptr) {
+            std::cerr << "Failed to create temporary directory: " << strerror(errno) << std::endl;
+            return EXIT_FAILURE;
+        }
+        options.dir = tmpl;
+    }
+
+    std::cout << std::left << std::setw(10) << "sink" << std::right
+              << std::setw(8) << "threads" << std::setw(12) << "ns/call" << std::setw(14) << "lines/s"
+              << std::setw(10) << "p50 ns" << std::setw(10) << "p99 ns" << std::setw(11) << "p99.9 ns"
+              << std::setw(12) << "max ns" << std::setw(11) << "dropped" << std::setw(11) << "rss +KB"
+              << std::setw(11) << "peak +KB" << std::endl;
+
+    int failures = 0;
+    for (const auto& sink : options.sinks) {
+        for (unsigned threads : options.threads) {
+            if (threads == 0) {
+                continue;
+            }
+            BenchResult result{};
+            if (!runInChild(sink, threads, options, result)) {
+                std::cout << std::left << std::setw(10) << sink << std::right << std::setw(8) << threads
+                          << "  failed" << std::endl;
+                ++failures;
+                continue;
+            }
+            std::cout << std::left << std::setw(10) << sink << std::right << std::setw(8) << threads
+                      << std::fixed << std::setprecision(1) << std::setw(12) << result.ns_per_call
+                      << std::setprecision(0) << std::setw(14) << result.lines_per_sec
+                      << std::setw(10) << result.p50_ns << std::setw(10) << result.p99_ns
+                      << std::setw(11) << result.p999_ns << std::setw(12) << result.max_ns
+                      << std::setw(11) << result.dropped << std::setw(11) << result.rss_growth_kb
+                      << std::setw(11) << result.peak_growth_kb << std::endl;
+        }
+    }
+
+    if (own_dir) {
+        std::error_code ec;
+        std::filesystem::remove_all(options.dir, ec);
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
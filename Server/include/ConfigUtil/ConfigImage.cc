@@ -0,0 +1,87 @@
+#include "ConfigImage.h"
+
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <unordered_map>
+
+namespace configimage {
+
+bool Encode(const std::vector<ConfigSnapshot::Entry>& entries, Body& body) {
+    body.table.clear();
+    body.text.clear();
+    body.table.reserve(entries.size());
+
+    // 同一节的键共用一份节名
+    std::string_view last_section;
+    uint32_t section_offset = 0;
+    // 来源(文件路径等)种类很少,每种只存一份
+    std::unordered_map<std::string_view, uint32_t> origins;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const auto& entry = entries[i];
+        if (i == 0 || entry.section != last_section) {
+            last_section = entry.section;
+            section_offset = static_cast<uint32_t>(body.text.size());
+            body.text.append(entry.section);
+        }
+        auto [origin, added] = origins.emplace(entry.origin, static_cast<uint32_t>(body.text.size()));
+        if (added) {
+            body.text.append(entry.origin);
+        }
+        Record r{};
+        r.section_offset = section_offset;
+        r.section_size = static_cast<uint32_t>(entry.section.size());
+        r.key_offset = static_cast<uint32_t>(body.text.size());
+        r.key_size = static_cast<uint32_t>(entry.key.size());
+        body.text.append(entry.key);
+        r.value_offset = static_cast<uint32_t>(body.text.size());
+        r.value_size = static_cast<uint32_t>(entry.value.size());
+        body.text.append(entry.value);
+        r.origin_offset = origin->second;
+        r.origin_size = static_cast<uint32_t>(entry.origin.size());
+        r.source = static_cast<uint8_t>(entry.source);
+        body.table.push_back(r);
+    }
+    return body.text.size() <= std::numeric_limits<uint32_t>::max();
+}
+
+bool Decode(const Record* table, uint32_t count, const char* text, uint64_t text_size,
+            std::vector<ConfigSnapshot::Entry>& entries) {
+    std::string_view view(text, text_size);
+    entries.clear();
+    entries.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const Record& r = table[i];
+        if (uint64_t(r.section_offset) + r.section_size > text_size
+            || uint64_t(r.key_offset) + r.key_size > text_size
+            || uint64_t(r.value_offset) + r.value_size > text_size
+            || uint64_t(r.origin_offset) + r.origin_size > text_size
+            || r.source > static_cast<uint8_t>(ConfigSource::COMMAND_LINE)) {
+            return false;
+        }
+        entries.push_back({view.substr(r.section_offset, r.section_size),
+                           view.substr(r.key_offset, r.key_size),
+                           view.substr(r.value_offset, r.value_size),
+                           static_cast<ConfigSource>(r.source),
+                           view.substr(r.origin_offset, r.origin_size)});
+    }
+    return true;
+}
+
+uint64_t Checksum(const void* data, size_t size) {
+    // FNV-1a的变体,每次吃进8字节,每步再把高位折回低位
+    const auto* p = static_cast<const unsigned char*>(data);
+    uint64_t hash = 0xcbf29ce484222325ULL ^ size;
+    for (; size >= 8; p += 8, size -= 8) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        hash = (hash ^ word) * 0x100000001b3ULL;
+        hash ^= hash >> 32;
+    }
+    for (; size > 0; ++p, --size) {
+        hash = (hash ^ *p) * 0x100000001b3ULL;
+    }
+    return hash ^ (hash >> 29);
+}
+
+} // namespace configimage
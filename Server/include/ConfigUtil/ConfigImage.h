@@ -0,0 +1,90 @@
+/**
+ * @file ConfigImage.h
+ * @author KevinGlaser
+ * @brief Binary layout of a flattened config table, shared by the Guardian's shared memory images
+ *        and the compiled <file>.bin next to a config file
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef __CONFIGIMAGE_H__
+#define __CONFIGIMAGE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ConfigSnapshot.h"
+
+/**
+ * An image body is a table of Record sorted by (section, key) followed by the text the records point
+ * into. Loading one is a bounds check per record and no parsing; the resulting ConfigSnapshot
+ * entries are views into the mapped text.
+ *
+ * A compiled config file (ConfigManager::compileConfig) is a FileHeader followed by the body. The
+ * header records inode, size and mtime of the INI file it was compiled from and a checksum of the body, so
+ * a stale, truncated or corrupted image is detected and the INI file is parsed instead.
+ */
+namespace configimage {
+
+// 偏移相对于文本区起始位置
+struct Record {
+    uint32_t section_offset;
+    uint32_t section_size;
+    uint32_t key_offset;
+    uint32_t key_size;
+    uint32_t value_offset;
+    uint32_t value_size;
+    uint32_t origin_offset;
+    uint32_t origin_size;
+    uint8_t source;         // ConfigSource
+    uint8_t reserved[3];
+};
+
+struct Body {
+    std::vector<Record> table;
+    std::string text;
+};
+
+constexpr char FILE_MAGIC[8] = {'C', 'M', 'S', 'C', 'B', 'I', 'N', '1'};
+constexpr uint32_t FILE_VERSION = 1;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_count;
+    uint64_t text_size;
+    uint64_t source_inode;          // 编译时INI文件的inode、大小和修改时间
+    uint64_t source_size;
+    int64_t source_mtime_sec;
+    int64_t source_mtime_nsec;
+    uint64_t checksum;              // 表和文本区的Checksum()
+};
+
+/**
+ * @brief lay out the entries of a snapshot as a body
+ *
+ * @return false the text does not fit 32 bit offsets
+ */
+bool Encode(const std::vector<ConfigSnapshot::Entry>& entries, Body& body);
+
+/**
+ * @brief turn count records into snapshot entries viewing text
+ *
+ * @return false a record points outside text
+ */
+bool Decode(const Record* table, uint32_t count, const char* text, uint64_t text_size,
+            std::vector<ConfigSnapshot::Entry>& entries);
+
+/**
+ * @brief 64 bit hash of size bytes, 8 bytes per step; detects truncation and corruption, not tampering
+ */
+uint64_t Checksum(const void* data, size_t size);
+
+} // namespace configimage
+
+#endif
@@ -0,0 +1,119 @@
+/**
+ * @file ConfigKey.h
+ * @author KevinGlaser
+ * @brief Compile-time key handles for the typed accessors of ConfigSnapshot
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef __CONFIGKEY_H__
+#define __CONFIGKEY_H__
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <variant>
+
+enum class ConfigType : uint8_t {
+    INT,        // int64_t
+    DOUBLE,     // double
+    BOOL,       // true/false, yes/no, on/off, 1/0
+    DURATION,   // std::chrono::milliseconds, "250ms" "5s" "2min" "1h", a bare number is milliseconds
+    SIZE,       // uint64_t bytes, "512" "64K" "16MB" "1G", units are powers of 1024
+    STRING      // std::string, as written in the file
+};
+
+using ConfigValue = std::variant<int64_t, double, bool, std::chrono::milliseconds, uint64_t, std::string>;
+
+template <typename T> struct ConfigTypeOf;
+template <> struct ConfigTypeOf<int64_t> { static constexpr ConfigType value = ConfigType::INT; };
+template <> struct ConfigTypeOf<double> { static constexpr ConfigType value = ConfigType::DOUBLE; };
+template <> struct ConfigTypeOf<bool> { static constexpr ConfigType value = ConfigType::BOOL; };
+template <> struct ConfigTypeOf<std::chrono::milliseconds> { static constexpr ConfigType value = ConfigType::DURATION; };
+template <> struct ConfigTypeOf<uint64_t> { static constexpr ConfigType value = ConfigType::SIZE; };
+template <> struct ConfigTypeOf<std::string> { static constexpr ConfigType value = ConfigType::STRING; };
+
+/**
+ * @brief FNV-1a over section, a NUL separator and key
+ */
+constexpr uint64_t ConfigKeyHash(std::string_view section, std::string_view key) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : section) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ULL;
+    }
+    hash = hash * 1099511628211ULL;
+    for (char c : key) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief One entry of the key schema. Every typed key is declared once in ConfigKeys.h with its
+ *        type and the default used when the file does not set it or sets it to an invalid value.
+ */
+struct ConfigKeyDef {
+    std::string_view section;
+    std::string_view key;
+    ConfigType type;
+    std::string_view default_value;
+    uint64_t hash;
+
+    constexpr ConfigKeyDef(std::string_view section, std::string_view key, ConfigType type,
+                           std::string_view default_value)
+        : section(section), key(key), type(type), default_value(default_value)
+        , hash(ConfigKeyHash(section, key)) {}
+};
+
+/**
+ * @brief Handle of a typed key, slot is the index of its definition in the schema and the index of
+ *        its parsed value in every ConfigSnapshot
+ */
+template <typename T>
+struct ConfigKey {
+    size_t slot;
+    std::string_view section;
+    std::string_view key;
+};
+
+/**
+ * @brief resolve section/key to its slot in schema, must initialize a constexpr variable so a
+ *        missing key or a type mismatch fails the build instead of throwing at runtime
+ */
+template <typename T, size_t N>
+constexpr ConfigKey<T> DeclareConfigKey(const ConfigKeyDef (&schema)[N], std::string_view section,
+                                        std::string_view key) {
+    uint64_t hash = ConfigKeyHash(section, key);
+    for (size_t i = 0; i < N; ++i) {
+        if (schema[i].hash == hash && schema[i].section == section && schema[i].key == key) {
+            if (schema[i].type != ConfigTypeOf<T>::value) {
+                throw std::logic_error("config key declared with a different type");
+            }
+            return ConfigKey<T>{i, section, key};
+        }
+    }
+    throw std::logic_error("config key missing from the schema");
+}
+
+/**
+ * @brief true when no two entries of schema share a hash, checked with static_assert
+ */
+template <size_t N>
+constexpr bool ConfigSchemaUnique(const ConfigKeyDef (&schema)[N]) {
+    for (size_t i = 0; i < N; ++i) {
+        for (size_t j = i + 1; j < N; ++j) {
+            if (schema[i].hash == schema[j].hash) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+#endif
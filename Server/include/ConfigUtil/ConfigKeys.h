@@ -0,0 +1,38 @@
+/**
+ * @file ConfigKeys.h
+ * @author KevinGlaser
+ * @brief Schema of the typed configuration keys and their handles
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef __CONFIGKEYS_H__
+#define __CONFIGKEYS_H__
+
+#include "ConfigKey.h"
+
+namespace config_keys {
+
+// 新增配置项时在这里登记类型和默认值,再声明对应的句柄
+inline constexpr ConfigKeyDef SCHEMA[] = {
+    {"Log", "level", ConfigType::STRING, "DEBUG"},
+    {"Log", "queue_capacity", ConfigType::INT, "1024"},
+    {"Log", "flight_recorder_size", ConfigType::SIZE, "1M"},
+    {"Config", "binary_cache", ConfigType::BOOL, "false"},
+};
+
+static_assert(ConfigSchemaUnique(SCHEMA), "two config keys hash to the same value");
+
+inline constexpr size_t SLOT_COUNT = sizeof(SCHEMA) / sizeof(SCHEMA[0]);
+
+inline constexpr auto LOG_LEVEL = DeclareConfigKey<std::string>(SCHEMA, "Log", "level");
+inline constexpr auto LOG_QUEUE_CAPACITY = DeclareConfigKey<int64_t>(SCHEMA, "Log", "queue_capacity");
+inline constexpr auto LOG_FLIGHT_RECORDER_SIZE = DeclareConfigKey<uint64_t>(SCHEMA, "Log", "flight_recorder_size");
+inline constexpr auto CONFIG_BINARY_CACHE = DeclareConfigKey<bool>(SCHEMA, "Config", "binary_cache");
+
+} // namespace config_keys
+
+#endif
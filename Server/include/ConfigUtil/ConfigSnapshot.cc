@@ -0,0 +1,372 @@
+#include "ConfigSnapshot.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+std::string lower(std::string_view text) {
+    std::string result(text);
+    for (auto& c : result) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return result;
+}
+
+// 解析开头的数字,unit返回其后的单位部分
+bool parseNumber(std::string_view text, double& number, std::string& unit) {
+    std::string buffer(text);
+    errno = 0;
+    char* end = nullptr;
+    number = std::strtod(buffer.c_str(), &end);
+    if (end == buffer.c_str() || errno == ERANGE || !std::isfinite(number)) {
+        return false;
+    }
+    unit = lower(trim(std::string_view(end)));
+    return true;
+}
+
+bool parseValue(ConfigType type, std::string_view raw, ConfigValue& out) {
+    std::string_view text = trim(raw);
+    switch (type) {
+        case ConfigType::INT: {
+            std::string buffer(text);
+            errno = 0;
+            char* end = nullptr;
+            long long value = std::strtoll(buffer.c_str(), &end, 10);
+            if (buffer.empty() || *end != '\0' || errno == ERANGE) {
+                return false;
+            }
+            out = static_cast<int64_t>(value);
+            return true;
+        }
+        case ConfigType::DOUBLE: {
+            double value;
+            std::string unit;
+            if (!parseNumber(text, value, unit) || !unit.empty()) {
+                return false;
+            }
+            out = value;
+            return true;
+        }
+        case ConfigType::BOOL: {
+            std::string value = lower(text);
+            if (value == "true" || value == "yes" || value == "on" || value == "1") {
+                out = true;
+                return true;
+            }
+            if (value == "false" || value == "no" || value == "off" || value == "0") {
+                out = false;
+                return true;
+            }
+            return false;
+        }
+        case ConfigType::DURATION: {
+            double value;
+            std::string unit;
+            if (!parseNumber(text, value, unit) || value < 0) {
+                return false;
+            }
+            double scale;
+            if (unit.empty() || unit == "ms") scale = 1;
+            else if (unit == "s") scale = 1000;
+            else if (unit == "min") scale = 60 * 1000;
+            else if (unit == "h") scale = 3600 * 1000;
+            else return false;
+            out = std::chrono::milliseconds(static_cast<int64_t>(std::llround(value * scale)));
+            return true;
+        }
+        case ConfigType::SIZE: {
+            double value;
+            std::string unit;
+            if (!parseNumber(text, value, unit) || value < 0) {
+                return false;
+            }
+            double scale;
+            if (unit.empty() || unit == "b") scale = 1;
+            else if (unit == "k" || unit == "kb") scale = 1024.0;
+            else if (unit == "m" || unit == "mb") scale = 1024.0 * 1024;
+            else if (unit == "g" || unit == "gb") scale = 1024.0 * 1024 * 1024;
+            else return false;
+            out = static_cast<uint64_t>(std::llround(value * scale));
+            return true;
+        }
+        case ConfigType::STRING:
+            out = std::string(raw);
+            return true;
+    }
+    return false;
+}
+} // namespace
+
+const char* ConfigSourceName(ConfigSource source) {
+    switch (source) {
+        case ConfigSource::DEFAULT: return "default";
+        case ConfigSource::FILE: return "file";
+        case ConfigSource::INCLUDE: return "include";
+        case ConfigSource::ENVIRONMENT: return "environment";
+        case ConfigSource::COMMAND_LINE: return "command line";
+    }
+    return "unknown";
+}
+
+ConfigSnapshot::ConfigSnapshot(std::vector<ConfigLayer> layers, std::shared_ptr<const ConfigSnapshot> base)
+    : layers_(std::move(layers)), storage_(base) {
+    // 默认值总在最底层,base可能是编译好的配置文件镜像,其上再叠加包含目录和覆盖项
+    std::vector<size_t> runs;
+    for (const auto& layer : layers_) {
+        if (layer.source == ConfigSource::DEFAULT) {
+            runs.push_back(entries_.size());
+            tokenize(layer);
+        }
+    }
+    // base的条目视图由storage_保活
+    if (base) {
+        runs.push_back(entries_.size());
+        entries_.insert(entries_.end(), base->entries().begin(), base->entries().end());
+    }
+    for (const auto& layer : layers_) {
+        if (layer.source == ConfigSource::DEFAULT) {
+            continue;
+        }
+        runs.push_back(entries_.size());
+        if (layer.source == ConfigSource::ENVIRONMENT) {
+            resolveEnvironment(layer, entries_.size());
+        } else {
+            tokenize(layer);
+        }
+    }
+    sortEntries(runs);
+    parseTyped();
+}
+
+ConfigSnapshot::ConfigSnapshot(std::shared_ptr<const void> storage, std::vector<Entry> entries)
+    : storage_(std::move(storage)), entries_(std::move(entries)) {
+    parseTyped();
+}
+
+ConfigSnapshot::ConfigSnapshot(const ConfigMap& config) {
+    // 先把所有字符串拼进text_,记录偏移,全部写完后再生成视图,避免扩容使视图失效
+    size_t total = 0;
+    size_t count = 0;
+    for (const auto& [section, values] : config) {
+        total += section.size();
+        for (const auto& [key, value] : values) {
+            total += key.size() + value.size();
+            ++count;
+        }
+    }
+    text_.reserve(total);
+
+    struct Offsets { size_t section, section_len, key, key_len, value, value_len; };
+    std::vector<Offsets> offsets;
+    offsets.reserve(count);
+    for (const auto& [section, values] : config) {
+        size_t section_pos = text_.size();
+        text_.append(section);
+        for (const auto& [key, value] : values) {
+            size_t key_pos = text_.size();
+            text_.append(key);
+            size_t value_pos = text_.size();
+            text_.append(value);
+            offsets.push_back({section_pos, section.size(), key_pos, key.size(), value_pos, value.size()});
+        }
+    }
+
+    // map本身有序,直接得到排好序的表
+    std::string_view view(text_);
+    entries_.reserve(count);
+    for (const auto& o : offsets) {
+        entries_.push_back({view.substr(o.section, o.section_len), view.substr(o.key, o.key_len),
+                            view.substr(o.value, o.value_len), ConfigSource::FILE, std::string_view()});
+    }
+    parseTyped();
+}
+
+void ConfigSnapshot::tokenize(const ConfigLayer& layer) {
+    std::string_view text(layer.text);
+    std::string_view section;
+
+    // 与原getline解析器的规则一致:跳过空行和#注释行,[section]切换节,key=value属于当前节
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t eol = text.find('\n', pos);
+        if (eol == std::string_view::npos) {
+            eol = text.size();
+        }
+        std::string_view line = text.substr(pos, eol - pos);
+        pos = eol + 1;
+
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        if (line[0] == '[') {
+            size_t end = line.find(']');
+            if (end != std::string_view::npos) {
+                section = line.substr(1, end - 1);
+            }
+            continue;
+        }
+        size_t eq = line.find('=');
+        if (eq != std::string_view::npos && !section.empty()) {
+            entries_.push_back({section, line.substr(0, eq), line.substr(eq + 1), layer.source, layer.origin});
+        }
+    }
+}
+
+void ConfigSnapshot::resolveEnvironment(const ConfigLayer& layer, size_t known) {
+    static const std::string_view PREFIX = "CPPMS_";
+    auto same = [](std::string_view a, std::string_view b) {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+            return std::toupper(static_cast<unsigned char>(x)) == std::toupper(static_cast<unsigned char>(y));
+        });
+    };
+
+    std::string_view text(layer.text);
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t eol = text.find('\n', pos);
+        if (eol == std::string_view::npos) {
+            eol = text.size();
+        }
+        std::string_view line = text.substr(pos, eol - pos);
+        pos = eol + 1;
+
+        size_t eq = line.find('=');
+        if (eq == std::string_view::npos || line.substr(0, PREFIX.size()) != PREFIX) {
+            continue;
+        }
+        std::string_view name = line.substr(0, eq);
+        std::string_view path = name.substr(PREFIX.size());
+        size_t split = path.find("__");
+        if (split == std::string_view::npos) {
+            errors_.push_back("environment variable " + std::string(name) + " is not CPPMS_<SECTION>__<KEY>");
+            continue;
+        }
+        std::string_view section = path.substr(0, split);
+        std::string_view key = path.substr(split + 2);
+
+        // 只覆盖前面各层已有的键,并沿用其原本的大小写
+        const Entry* match = nullptr;
+        for (size_t i = 0; i < known && match == nullptr; ++i) {
+            if (same(entries_[i].section, section) && same(entries_[i].key, key)) {
+                match = &entries_[i];
+            }
+        }
+        if (match == nullptr) {
+            errors_.push_back("environment variable " + std::string(name) + " matches no config key");
+            continue;
+        }
+        Entry entry{match->section, match->key, line.substr(eq + 1), layer.source, name};
+        entries_.push_back(entry);
+    }
+}
+
+void ConfigSnapshot::sortEntries(const std::vector<size_t>& runs) {
+    auto less = [](const Entry& a, const Entry& b) {
+        int cmp = a.section.compare(b.section);
+        return cmp != 0 ? cmp < 0 : a.key < b.key;
+    };
+    // 每层单独排序后依次归并到前面的结果上:单个生成的配置文件和base通常已经有序,只需线性归并。
+    // 排序和归并都是稳定的,同一键保留各层及文件中的先后顺序,下面只保留最后一次出现,即优先级最高的来源
+    for (size_t r = 0; r < runs.size(); ++r) {
+        auto first = entries_.begin() + runs[r];
+        auto last = r + 1 < runs.size() ? entries_.begin() + runs[r + 1] : entries_.end();
+        if (!std::is_sorted(first, last, less)) {
+            std::stable_sort(first, last, less);
+        }
+        if (first != entries_.begin() && first != last && less(*first, *(first - 1))) {
+            std::inplace_merge(entries_.begin(), first, last, less);
+        }
+    }
+    size_t out = 0;
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        if (i + 1 < entries_.size() && entries_[i + 1].section == entries_[i].section
+            && entries_[i + 1].key == entries_[i].key) {
+            continue;
+        }
+        entries_[out++] = entries_[i];
+    }
+    entries_.resize(out);
+}
+
+void ConfigSnapshot::parseTyped() {
+    // 已登记的配置项在加载时一次性解析并校验,之后读取不再解析
+    typed_.resize(config_keys::SLOT_COUNT);
+    for (size_t slot = 0; slot < config_keys::SLOT_COUNT; ++slot) {
+        const ConfigKeyDef& def = config_keys::SCHEMA[slot];
+        const std::string_view* value = find(def.section, def.key);
+        if (value != nullptr && parseValue(def.type, *value, typed_[slot])) {
+            continue;
+        }
+        if (value != nullptr) {
+            errors_.push_back("[" + std::string(def.section) + "] " + std::string(def.key) + ": invalid value '"
+                              + std::string(*value) + "', using default '" + std::string(def.default_value) + "'");
+        }
+        parseValue(def.type, def.default_value, typed_[slot]);
+    }
+}
+
+ConfigSnapshot::ConfigMap ConfigSnapshot::all() const {
+    ConfigMap config;
+    SectionMap* current = nullptr;
+    std::string_view current_name;
+    for (const auto& entry : entries_) {
+        if (current == nullptr || entry.section != current_name) {
+            current_name = entry.section;
+            current = &config[std::string(current_name)];
+        }
+        // 表已有序,每次都插在末尾
+        current->emplace_hint(current->end(), entry.key, entry.value);
+    }
+    return config;
+}
+
+ConfigSnapshot::Range ConfigSnapshot::section(std::string_view section) const {
+    auto first = std::lower_bound(entries_.begin(), entries_.end(), section,
+        [](const Entry& entry, std::string_view name) { return entry.section < name; });
+    auto last = std::upper_bound(first, entries_.end(), section,
+        [](std::string_view name, const Entry& entry) { return name < entry.section; });
+    return Range{entries_.data() + (first - entries_.begin()), entries_.data() + (last - entries_.begin())};
+}
+
+const ConfigSnapshot::Entry* ConfigSnapshot::lookup(std::string_view section, std::string_view key) const {
+    auto it = std::lower_bound(entries_.begin(), entries_.end(), std::make_pair(section, key),
+        [](const Entry& entry, const std::pair<std::string_view, std::string_view>& target) {
+            return entry.section != target.first ? entry.section < target.first : entry.key < target.second;
+        });
+    if (it == entries_.end() || it->section != section || it->key != key) {
+        return nullptr;
+    }
+    return &*it;
+}
+
+const std::string_view* ConfigSnapshot::find(std::string_view section, std::string_view key) const {
+    const Entry* entry = lookup(section, key);
+    return entry == nullptr ? nullptr : &entry->value;
+}
+
+std::string ConfigSnapshot::describe() const {
+    std::string text;
+    for (const auto& entry : entries_) {
+        text.append("[").append(entry.section).append("] ").append(entry.key).append("=").append(entry.value)
+            .append(" (").append(ConfigSourceName(entry.source));
+        if (!entry.origin.empty()) {
+            text.append(" ").append(entry.origin);
+        }
+        text.append(")\n");
+    }
+    return text;
+}
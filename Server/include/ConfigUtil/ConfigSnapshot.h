@@ -0,0 +1,167 @@
+/**
+ * @file ConfigSnapshot.h
+ * @author KevinGlaser
+ * @brief Immutable parsed configuration shared by ConfigManager's readers
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef __CONFIGSNAPSHOT_H__
+#define __CONFIGSNAPSHOT_H__
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ConfigKeys.h"
+
+/**
+ * @brief Where a resolved value came from, in increasing precedence
+ */
+enum class ConfigSource : uint8_t {
+    DEFAULT,        // ConfigKeys.h
+    FILE,           // the config file
+    INCLUDE,        // *.conf in the include directory, in name order
+    ENVIRONMENT,    // CPPMS_<SECTION>__<KEY>
+    COMMAND_LINE    // --section.key=value
+};
+
+const char* ConfigSourceName(ConfigSource source);
+
+/**
+ * @brief Raw text of one configuration source. DEFAULT, FILE, INCLUDE and COMMAND_LINE layers are in
+ *        the INI format of the config file. An ENVIRONMENT layer holds NAME=value lines, NAME being
+ *        CPPMS_<SECTION>__<KEY>; it only overrides keys some earlier layer defines, matched without
+ *        regard to case, since environment variable names are conventionally upper case.
+ */
+struct ConfigLayer {
+    ConfigSource source;
+    std::string origin;     // file path, "ConfigKeys.h" for defaults, empty for the other sources
+    std::string text;
+};
+
+/**
+ * @brief One resolved version of the configuration. Never modified after construction, so any number
+ *        of threads may read it while ConfigManager replaces it with a newer one. The text of every
+ *        layer is kept as it was read and tokenized in place: each entry is a few string_views into
+ *        it, all layers are flattened into one table sorted by (section, key) where the highest
+ *        layer wins, so a lookup is a binary search that never walks the layers and allocates
+ *        nothing. The keys declared in ConfigKeys.h are also parsed to their types once here, so
+ *        get() is an array index with no parsing.
+ */
+class ConfigSnapshot {
+public:
+    using SectionMap = std::map<std::string, std::string>;
+    using ConfigMap = std::map<std::string, SectionMap>;
+
+    struct Entry {
+        std::string_view section;
+        std::string_view key;
+        std::string_view value;
+        ConfigSource source;
+        std::string_view origin;    // file path or environment variable name the value came from
+    };
+
+    /**
+     * @brief entries of one section, in key order
+     */
+    struct Range {
+        const Entry* first;
+        const Entry* last;
+
+        const Entry* begin() const { return first; }
+        const Entry* end() const { return last; }
+        bool empty() const { return first == last; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+    };
+
+    /**
+     * @brief tokenize and flatten layers, later layers override earlier ones and all of them override
+     *        base, except DEFAULT layers which always stay below base; the snapshot keeps the layer
+     *        texts and base as its storage
+     */
+    explicit ConfigSnapshot(std::vector<ConfigLayer> layers, std::shared_ptr<const ConfigSnapshot> base = nullptr);
+
+    /**
+     * @brief build a snapshot from already parsed sections
+     */
+    explicit ConfigSnapshot(const ConfigMap& config);
+
+    /**
+     * @brief wrap a table that is already sorted, holds each key once and points into storage,
+     *        e.g. a shared memory image; the snapshot keeps storage alive
+     */
+    ConfigSnapshot(std::shared_ptr<const void> storage, std::vector<Entry> entries);
+
+    ConfigSnapshot(const ConfigSnapshot&) = delete;
+    ConfigSnapshot& operator=(const ConfigSnapshot&) = delete;
+
+    /**
+     * @brief the sorted table, one entry per section/key; for a key set more than once the last one wins
+     */
+    const std::vector<Entry>& entries() const { return entries_; }
+
+    /**
+     * @brief all sections with their key-value pairs, copied into maps for the ConfigManager API
+     */
+    ConfigMap all() const;
+
+    /**
+     * @brief key-value pairs of one section, empty if the section does not exist
+     */
+    Range section(std::string_view section) const;
+
+    /**
+     * @brief value of section/key
+     * @return nullptr if the key does not exist
+     */
+    const std::string_view* find(std::string_view section, std::string_view key) const;
+
+    /**
+     * @brief entry of section/key with the source of its value
+     * @return nullptr if the key does not exist
+     */
+    const Entry* lookup(std::string_view section, std::string_view key) const;
+
+    /**
+     * @brief every resolved value with its source, one "[section] key=value (source origin)" per line
+     */
+    std::string describe() const;
+
+    /**
+     * @brief typed value of a key declared in ConfigKeys.h, the schema default if the file does not
+     *        set it or its value did not parse
+     */
+    template <typename T>
+    const T& get(const ConfigKey<T>& key) const { return std::get<T>(typed_[key.slot]); }
+
+    /**
+     * @brief one message per typed key whose value did not parse and was replaced by its default,
+     *        and per environment variable that matches no key
+     */
+    const std::vector<std::string>& errors() const { return errors_; }
+
+private:
+    void tokenize(const ConfigLayer& layer);
+    void resolveEnvironment(const ConfigLayer& layer, size_t known);
+    /**
+     * @brief sort and dedupe entries_, runs are the start offsets of the layers in precedence order
+     */
+    void sortEntries(const std::vector<size_t>& runs);
+    void parseTyped();
+
+    std::vector<ConfigLayer> layers_;
+    std::string text_;
+    std::shared_ptr<const void> storage_;   // 条目指向外部存储时由它保活
+    std::vector<Entry> entries_;            // 视图指向layers_、text_或storage_,快照生命周期内一直有效
+    std::vector<ConfigValue> typed_;        // 下标即config_keys::SCHEMA中的槽位
+    std::vector<std::string> errors_;
+};
+
+#endif
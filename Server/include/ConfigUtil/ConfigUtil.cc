@@ -1,33 +1,258 @@
 #include "ConfigUtil.h"
-#include <fstream>
+#include "ConfigImage.h"
 #include <filesystem>
 #include <stdexcept>
 #include <iostream>
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+extern char** environ;
 
 namespace fs = std::filesystem;
 
-std::filesystem::path ConfigManager::getConfigPath(const std::string& filename) {
-    fs::path configPath;
+// 两次检查配置文件是否变化的最小间隔
+static const std::chrono::milliseconds STAT_CHECK_INTERVAL(1000);
+
+namespace {
+// 判断文件是否被修改或替换(rename后inode会变)
+struct FileIdentity {
+    dev_t dev = 0;
+    ino_t ino = 0;
+    off_t size = 0;
+    long mtime_sec = 0;
+    long mtime_nsec = 0;
+
+    bool operator==(const FileIdentity& other) const {
+        return dev == other.dev && ino == other.ino && size == other.size
+            && mtime_sec == other.mtime_sec && mtime_nsec == other.mtime_nsec;
+    }
+};
+
+struct CacheEntry {
+    std::shared_ptr<const ConfigSnapshot> snapshot;
+    FileIdentity identity;
+    FileIdentity include_identity;      // 包含目录本身,增删或rename其中的文件会改变它的mtime
+    std::chrono::steady_clock::time_point checked;
+};
+
+std::mutex cache_mutex;
+std::unordered_map<std::string, CacheEntry> snapshot_cache;
+std::mutex command_line_mutex;
+std::string command_line_text;      // --section.key=value 参数转换成的INI文本
+
+// 整个文件读入一块缓冲区,由快照在原处切分,不为每个键值单独分配字符串
+std::string readFileText(const fs::path& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        throw std::runtime_error("Cannot open file: " + path.string());
+    }
+
+    struct stat st;
+    std::string text;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        text.resize(static_cast<size_t>(st.st_size));
+    }
+    size_t length = 0;
+    while (true) {
+        if (length == text.size()) {
+            // 读取期间文件变大时继续读到末尾
+            text.resize(text.size() + 4096);
+        }
+        ssize_t n = read(fd, &text[length], text.size() - length);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            int err = errno;
+            close(fd);
+            throw std::runtime_error("Cannot read file: " + path.string() + ": " + strerror(err));
+        }
+        if (n == 0) {
+            break;
+        }
+        length += static_cast<size_t>(n);
+    }
+    close(fd);
+    text.resize(length);
+    return text;
+}
+
+// 写入临时文件并落盘后rename替换,崩溃时只会看到旧文件或完整的新文件
+bool writeFileAtomic(const fs::path& path, std::string_view content) {
+    fs::path tempPath = fs::path(path).concat(".tmp." + std::to_string(getpid()));
+    int fd = open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        std::cerr << "Write failed: cannot create " << tempPath << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    size_t written = 0;
+    while (written < content.size()) {
+        ssize_t n = write(fd, content.data() + written, content.size() - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        written += static_cast<size_t>(n);
+    }
+    bool ok = written == content.size() && fsync(fd) == 0;
+    if (close(fd) != 0) {
+        ok = false;
+    }
+    if (!ok || rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "Write failed: " << tempPath << ": " << strerror(errno) << std::endl;
+        unlink(tempPath.c_str());
+        return false;
+    }
+
+    // rename本身记录在目录中,目录也需要同步
+    int dir_fd = open(path.parent_path().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd != -1) {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+    return true;
+}
+
+bool olderThan(const timespec& a, const timespec& b) {
+    return a.tv_sec != b.tv_sec ? a.tv_sec < b.tv_sec : a.tv_nsec < b.tv_nsec;
+}
+
+// 映射编译好的镜像,过期、截断或校验失败时返回nullptr,由调用者回退到解析文本
+std::shared_ptr<const ConfigSnapshot> loadCompiled(const fs::path& path, const struct stat& source) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(configimage::FileHeader)
+        || olderThan(st.st_mtim, source.st_mtim)) {
+        close(fd);
+        return nullptr;
+    }
+    // 镜像只会被rename整体替换,不会在原处截断,映射期间不会因文件变短而SIGBUS
+    size_t size = static_cast<size_t>(st.st_size);
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return nullptr;
+    }
+
+    auto* header = static_cast<const configimage::FileHeader*>(addr);
+    const char* body = reinterpret_cast<const char*>(header + 1);
+    uint64_t table_size = static_cast<uint64_t>(header->entry_count) * sizeof(configimage::Record);
+    std::vector<ConfigSnapshot::Entry> entries;
+    bool valid = memcmp(header->magic, configimage::FILE_MAGIC, sizeof(configimage::FILE_MAGIC)) == 0
+        && header->version == configimage::FILE_VERSION
+        && header->source_inode == static_cast<uint64_t>(source.st_ino)
+        && header->source_size == static_cast<uint64_t>(source.st_size)
+        && header->source_mtime_sec == static_cast<int64_t>(source.st_mtim.tv_sec)
+        && header->source_mtime_nsec == static_cast<int64_t>(source.st_mtim.tv_nsec)
+        && table_size + header->text_size == size - sizeof(configimage::FileHeader);
+    if (valid && configimage::Checksum(body, size - sizeof(configimage::FileHeader)) != header->checksum) {
+        std::cerr << "Ignoring corrupt compiled config " << path << std::endl;
+        valid = false;
+    }
+    if (!valid || !configimage::Decode(reinterpret_cast<const configimage::Record*>(body), header->entry_count,
+                                       body + table_size, header->text_size, entries)) {
+        munmap(addr, size);
+        return nullptr;
+    }
+
+    // 快照持有映射,最后一个引用释放时才解除映射
+    std::shared_ptr<const void> storage(addr, [size](const void* p) { munmap(const_cast<void*>(p), size); });
+    return std::make_shared<const ConfigSnapshot>(std::move(storage), std::move(entries));
+}
+
+bool statIdentity(const fs::path& path, FileIdentity& identity) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    identity.dev = st.st_dev;
+    identity.ino = st.st_ino;
+    identity.size = st.st_size;
+    identity.mtime_sec = static_cast<long>(st.st_mtim.tv_sec);
+    identity.mtime_nsec = static_cast<long>(st.st_mtim.tv_nsec);
+    return true;
+}
+
+fs::path resolveExecutableDir() {
 #ifdef WIN32_PLATFORM
     char buffer[MAX_PATH];
     GetModuleFileNameA(NULL, buffer, MAX_PATH);
-    configPath = fs::path(buffer).parent_path() / filename;
+    return fs::path(buffer).parent_path();
 #else
     char buffer[PATH_MAX];
     ssize_t len = readlink("/proc/self/exe", buffer, sizeof(buffer)-1);
     if (len != -1) {
         buffer[len] = '\0';
-        configPath = fs::path(buffer).parent_path() / filename;
-    } else {
-        // 如果readlink失败，使用当前工作目录
-        configPath = fs::current_path() / filename;
+        return fs::path(buffer).parent_path();
     }
+    // 如果readlink失败，使用当前工作目录
+    return fs::current_path();
 #endif
-    return configPath;
+}
+} // namespace
+
+std::filesystem::path ConfigManager::getConfigPath(const std::string& filename) {
+    // 可执行文件所在目录在进程生命周期内不变,只解析一次
+    static const fs::path exe_dir = resolveExecutableDir();
+    return exe_dir / filename;
+}
+
+std::shared_ptr<const ConfigSnapshot> ConfigManager::getSnapshot(const std::string& filename) {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(cache_mutex);
+
+    auto it = snapshot_cache.find(filename);
+    if (it != snapshot_cache.end() && now - it->second.checked < STAT_CHECK_INTERVAL) {
+        return it->second.snapshot;
+    }
+
+    // 文件不存在时标识为全零,之后创建了文件同样能发现
+    FileIdentity identity;
+    FileIdentity include_identity;
+    statIdentity(getConfigPath(filename), identity);
+    statIdentity(getIncludeDir(filename), include_identity);
+    if (it != snapshot_cache.end() && identity == it->second.identity
+        && include_identity == it->second.include_identity) {
+        it->second.checked = now;
+        return it->second.snapshot;
+    }
+
+    // 文件发生变化或首次读取,重新解析
+    auto snapshot = loadSnapshot(filename);
+    snapshot_cache[filename] = CacheEntry{snapshot, identity, include_identity, now};
+    return snapshot;
 }
 
-std::filesystem::path ConfigManager::getBackupPath(const std::string& filename) {
-    return getConfigPath(filename).concat(".bak");
+std::shared_ptr<const ConfigSnapshot> ConfigManager::reload(const std::string& filename) {
+    // 先取文件标识再解析,解析期间文件再次变化时下一次stat检查仍会发现
+    FileIdentity identity;
+    FileIdentity include_identity;
+    statIdentity(getConfigPath(filename), identity);
+    statIdentity(getIncludeDir(filename), include_identity);
+    auto snapshot = loadSnapshot(filename);
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    snapshot_cache[filename] = CacheEntry{snapshot, identity, include_identity, std::chrono::steady_clock::now()};
+    return snapshot;
+}
+
+void ConfigManager::invalidateCache(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    snapshot_cache.erase(filename);
 }
 
 bool ConfigManager::isValidPath(const std::filesystem::path& path) {
@@ -42,9 +267,12 @@ std::string ConfigManager::readConfigByKey(const std::string& filename,
                                     const std::string& section,
                                     const std::string& key) {
     try {
-        auto sectionConfig = readConfigBySection(filename, section);
-        if (sectionConfig.count(key)) {
-            return sectionConfig[key];
+        auto snapshot = getSnapshot(filename);
+        if (const std::string_view* value = snapshot->find(section, key)) {
+            return std::string(*value);
+        }
+        if (snapshot->section(section).empty()) {
+            throw std::runtime_error("Failed to read section: Section not found: [" + section + "]");
         }
         throw std::runtime_error("Key not found: [" + section + "] " + key);
     } catch (const std::exception& e) {
@@ -56,138 +284,256 @@ bool ConfigManager::writeConfig(const std::string& filename,
                               const std::string& section,
                               const std::string& key,
                               const std::string& value) {
-    try {
-        if (!makeBackup(filename)) {
+    return writeConfigBatch(filename, {{section, {{key, value}}}});
+}
+
+bool ConfigManager::writeConfigBatch(const std::string& filename,
+    const std::map<std::string, std::map<std::string, std::string>>& updates) {
+    fs::path configPath = getConfigPath(filename);
+    if (!isValidPath(configPath)) {
+        return false;
+    }
+
+    // 锁加在单独的文件上:配置文件本身会被rename替换,锁在旧inode上无法互斥后来的写者
+    fs::path lockPath = fs::path(configPath).concat(".lock");
+    int lock_fd = open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (lock_fd == -1) {
+        std::cerr << "Cannot open config lock " << lockPath << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    while (flock(lock_fd, LOCK_EX) == -1) {
+        if (errno != EINTR) {
+            std::cerr << "Cannot lock " << lockPath << ": " << strerror(errno) << std::endl;
+            close(lock_fd);
             return false;
         }
+    }
+
+    bool ok = false;
+    try {
+        // 持锁后再读取,保证基于其他写者的最新结果修改
+        std::map<std::string, std::map<std::string, std::string>> config;
+        std::error_code ec;
+        if (fs::exists(configPath, ec)) {
+            config = parseConfigFile(filename);
+        }
+        for (const auto& [section, values] : updates) {
+            for (const auto& [key, value] : values) {
+                config[section][key] = value;
+            }
+        }
+        ok = writeConfigFile(filename, config);
+    } catch (const std::exception& e) {
+        std::cerr << "Write failed: " << e.what() << std::endl;
+    }
+    invalidateCache(filename);
 
-        auto config = parseConfigFile(filename);
-        config[section][key] = value;
+    flock(lock_fd, LOCK_UN);
+    close(lock_fd);
+    return ok;
+}
 
-        if (!writeConfigFile(filename, config)) {
-            restoreFromBackup(filename);
+std::filesystem::path ConfigManager::getCompiledPath(const std::string& filename) {
+    return fs::path(getConfigPath(filename)).concat(".bin");
+}
+
+bool ConfigManager::compileConfig(const std::string& filename) {
+    fs::path configPath = getConfigPath(filename);
+    // 先取文件标识再读取,读取期间文件变化时记录的是旧标识,之后加载会判定镜像过期
+    struct stat source;
+    if (!isValidPath(configPath) || stat(configPath.c_str(), &source) != 0) {
+        std::cerr << "Cannot compile config " << configPath << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    try {
+        std::vector<ConfigLayer> layers;
+        layers.push_back({ConfigSource::FILE, configPath.string(), readFileText(configPath)});
+        ConfigSnapshot file(std::move(layers));
+
+        configimage::Body body;
+        if (!configimage::Encode(file.entries(), body)) {
+            std::cerr << "Config too large to compile: " << body.text.size() << " bytes" << std::endl;
             return false;
         }
 
-        std::filesystem::remove(filename + ".bak");
-        return true;
+        configimage::FileHeader header{};
+        memcpy(header.magic, configimage::FILE_MAGIC, sizeof(configimage::FILE_MAGIC));
+        header.version = configimage::FILE_VERSION;
+        header.entry_count = static_cast<uint32_t>(body.table.size());
+        header.text_size = body.text.size();
+        header.source_inode = static_cast<uint64_t>(source.st_ino);
+        header.source_size = static_cast<uint64_t>(source.st_size);
+        header.source_mtime_sec = static_cast<int64_t>(source.st_mtim.tv_sec);
+        header.source_mtime_nsec = static_cast<int64_t>(source.st_mtim.tv_nsec);
+
+        std::string image(sizeof(header), '\0');
+        image.append(reinterpret_cast<const char*>(body.table.data()), body.table.size() * sizeof(configimage::Record));
+        image.append(body.text);
+        header.checksum = configimage::Checksum(image.data() + sizeof(header), image.size() - sizeof(header));
+        memcpy(&image[0], &header, sizeof(header));
+        return writeFileAtomic(getCompiledPath(filename), image);
     } catch (const std::exception& e) {
-        restoreFromBackup(filename);
+        std::cerr << "Cannot compile config: " << e.what() << std::endl;
         return false;
     }
 }
 
-bool ConfigManager::makeBackup(const std::string& filename) {
-    try {
-        fs::path srcPath = getConfigPath(filename);
-        fs::path backupPath = getBackupPath(filename);
-        
-        if (fs::exists(srcPath)) {
-            fs::copy_file(srcPath, backupPath, 
-                fs::copy_options::overwrite_existing);
-        }
-        return true;
-    } catch (const fs::filesystem_error& e) {
-        std::cerr << "Backup failed: " << e.what() << std::endl;
-        return false;
+std::filesystem::path ConfigManager::getIncludeDir(const std::string& filename) {
+    fs::path configPath = getConfigPath(filename);
+    return configPath.parent_path() / (configPath.stem().string() + ".d");
+}
+
+void ConfigManager::setCommandLine(int argc, char* argv[]) {
+    // 只取 --section.key=value 形式的参数,其余参数留给程序自己处理
+    std::map<std::string, std::map<std::string, std::string>> overrides;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg.compare(0, 2, "--") != 0) {
+            continue;
+        }
+        size_t dot = arg.find('.');
+        size_t eq = arg.find('=');
+        if (dot == std::string::npos || eq == std::string::npos || dot < 3 || eq <= dot + 1
+            || arg.find('\n') != std::string::npos) {
+            continue;
+        }
+        overrides[arg.substr(2, dot - 2)][arg.substr(dot + 1, eq - dot - 1)] = arg.substr(eq + 1);
+    }
+
+    std::string text;
+    for (const auto& [section, values] : overrides) {
+        text.append("[").append(section).append("]\n");
+        for (const auto& [key, value] : values) {
+            text.append(key).append("=").append(value).append("\n");
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(command_line_mutex);
+        command_line_text = std::move(text);
     }
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    snapshot_cache.clear();
 }
 
-bool ConfigManager::restoreFromBackup(const std::string& filename) {
-    try {
-        fs::path srcPath = getConfigPath(filename);
-        fs::path backupPath = getBackupPath(filename);
-        
-        if (fs::exists(backupPath)) {
-            fs::rename(backupPath, srcPath);
-        }
-        return true;
-    } catch (const fs::filesystem_error& e) {
-        std::cerr << "Restore failed: " << e.what() << std::endl;
-        return false;
+std::vector<ConfigLayer> ConfigManager::overrideLayers() {
+    std::vector<ConfigLayer> layers;
+
+    std::string env_text;
+    for (char** env = environ; env != nullptr && *env != nullptr; ++env) {
+        if (strncmp(*env, "CPPMS_", 6) == 0 && strchr(*env, '\n') == nullptr) {
+            env_text.append(*env).append("\n");
+        }
     }
+    if (!env_text.empty()) {
+        layers.push_back({ConfigSource::ENVIRONMENT, "", std::move(env_text)});
+    }
+
+    std::lock_guard<std::mutex> lock(command_line_mutex);
+    if (!command_line_text.empty()) {
+        layers.push_back({ConfigSource::COMMAND_LINE, "", command_line_text});
+    }
+    return layers;
 }
 
-std::map<std::string, std::map<std::string, std::string>> 
-ConfigManager::parseConfigFile(const std::string& filename) {
+std::shared_ptr<const ConfigSnapshot> ConfigManager::loadSnapshot(const std::string& filename) {
     fs::path configPath = getConfigPath(filename);
     if (!isValidPath(configPath)) {
         throw std::runtime_error("Invalid config file path: " + configPath.string());
     }
 
-    std::map<std::string, std::map<std::string, std::string>> config;
-    std::ifstream file(configPath);
-    if (!file.is_open()) {
-        throw std::runtime_error("Cannot open file: " + configPath.string());
+    std::vector<ConfigLayer> layers;
+
+    // 编译期登记的默认值
+    std::string defaults;
+    std::string_view section;
+    for (const auto& def : config_keys::SCHEMA) {
+        if (def.section != section) {
+            section = def.section;
+            defaults.append("[").append(section).append("]\n");
+        }
+        defaults.append(def.key).append("=").append(def.default_value).append("\n");
     }
+    layers.push_back({ConfigSource::DEFAULT, "ConfigKeys.h", std::move(defaults)});
 
-    std::string line, currentSection;
-    while (std::getline(file, line)) {
-        if (line.empty() || line[0] == '#') continue;
+    // 配置文件不存在时仍可由默认值、环境变量和命令行组成完整配置
+    struct stat source;
+    bool has_file = stat(configPath.c_str(), &source) == 0;
+    // 有效的编译镜像直接映射作为文件层,否则解析文本
+    std::shared_ptr<const ConfigSnapshot> compiled;
+    if (has_file) {
+        compiled = loadCompiled(getCompiledPath(filename), source);
+        if (!compiled) {
+            layers.push_back({ConfigSource::FILE, configPath.string(), readFileText(configPath)});
+        }
+    }
 
-        if (line[0] == '[') {
-            size_t end = line.find(']');
-            if (end != std::string::npos) {
-                currentSection = line.substr(1, end - 1);
+    // 包含目录中的 *.conf 按文件名顺序叠加
+    std::error_code ec;
+    fs::path includeDir = getIncludeDir(filename);
+    if (fs::is_directory(includeDir, ec)) {
+        std::vector<fs::path> includes;
+        for (const auto& item : fs::directory_iterator(includeDir, ec)) {
+            if (item.path().extension() == ".conf" && item.is_regular_file(ec)) {
+                includes.push_back(item.path());
             }
-            continue;
         }
-
-        size_t pos = line.find('=');
-        if (pos != std::string::npos && !currentSection.empty()) {
-            std::string key = line.substr(0, pos);
-            std::string value = line.substr(pos + 1);
-            config[currentSection][key] = value;
+        std::sort(includes.begin(), includes.end());
+        for (const auto& include : includes) {
+            layers.push_back({ConfigSource::INCLUDE, include.string(), readFileText(include)});
         }
     }
 
-    return config;
+    for (auto& layer : overrideLayers()) {
+        layers.push_back(std::move(layer));
+    }
+    bool parsed_file = has_file && !compiled;
+    auto snapshot = std::make_shared<const ConfigSnapshot>(std::move(layers), std::move(compiled));
+
+    // 只在刚解析过文本时重新编译,下次加载即可直接映射
+    if (parsed_file && snapshot->get(config_keys::CONFIG_BINARY_CACHE)) {
+        compileConfig(filename);
+    }
+    return snapshot;
+}
+
+std::map<std::string, std::map<std::string, std::string>> 
+ConfigManager::parseConfigFile(const std::string& filename) {
+    // 只解析配置文件本身,写回时不能把默认值和覆盖项写进文件
+    fs::path configPath = getConfigPath(filename);
+    if (!isValidPath(configPath)) {
+        throw std::runtime_error("Invalid config file path: " + configPath.string());
+    }
+    std::vector<ConfigLayer> layers;
+    layers.push_back({ConfigSource::FILE, configPath.string(), readFileText(configPath)});
+    return ConfigSnapshot(std::move(layers)).all();
 }
 
 bool ConfigManager::writeConfigFile(const std::string& filename,
     const std::map<std::string, std::map<std::string, std::string>>& config) {
     
     fs::path configPath = getConfigPath(filename);
-    fs::path tempPath = configPath.concat(".tmp");
-
     if (!isValidPath(configPath)) {
         return false;
     }
 
-    std::ofstream file(tempPath);
-    if (!file) {
-        return false;
-    }
-
+    std::string content;
     for (const auto& [section, values] : config) {
-        file << "[" << section << "]\n";
+        content.append("[").append(section).append("]\n");
         for (const auto& [key, value] : values) {
-            file << key << "=" << value << "\n";
+            content.append(key).append("=").append(value).append("\n");
         }
-        file << "\n";
-    }
-
-    file.close();
-    if (file.fail()) {
-        std::filesystem::remove(tempPath);
-        return false;
-    }
-
-    try {
-        fs::rename(tempPath, configPath);
-        return true;
-    } catch (const fs::filesystem_error& e) {
-        std::cerr << "Write failed: " << e.what() << std::endl;
-        fs::remove(tempPath);
-        return false;
+        content.append("\n");
     }
+    return writeFileAtomic(configPath, content);
 }
 
 // 读取整个配置文件
 std::map<std::string, std::map<std::string, std::string>> 
 ConfigManager::readAllConfig(const std::string& filename) {
     try {
-        return parseConfigFile(filename);
+        return getSnapshot(filename)->all();
     } catch (const std::exception& e) {
         throw std::runtime_error("Failed to read config file: " + std::string(e.what()));
     }
@@ -197,9 +543,14 @@ ConfigManager::readAllConfig(const std::string& filename) {
 std::map<std::string, std::string> 
 ConfigManager::readConfigBySection(const std::string& filename, const std::string& section) {
     try {
-        auto config = parseConfigFile(filename);
-        if (config.count(section)) {
-            return config[section];
+        auto snapshot = getSnapshot(filename);
+        ConfigSnapshot::Range values = snapshot->section(section);
+        if (!values.empty()) {
+            std::map<std::string, std::string> result;
+            for (const auto& entry : values) {
+                result.emplace_hint(result.end(), entry.key, entry.value);
+            }
+            return result;
         }
         throw std::runtime_error("Section not found: [" + section + "]");
     } catch (const std::exception& e) {
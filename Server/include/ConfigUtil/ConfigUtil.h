@@ -17,7 +17,11 @@
 
 #include <string>
 #include <map>
+#include <memory>
 #include <filesystem>
+#include <vector>
+
+#include "ConfigSnapshot.h"
 
 #ifdef WIN32_PLATFORM
     #include <windows.h>
@@ -31,7 +35,39 @@
 #endif
 
 class ConfigManager {
+    // 监视器需要用getConfigPath()/getIncludeDir()解析出实际监视的目录,并在共享快照上叠加overrideLayers()
+    friend class ConfigWatcher;
+
 public:
+    /**
+     * @brief Sets the --section.key=value overrides of the command line layer. Other arguments are
+     *        ignored. Call it from main() before the first read
+     * @param argc[in] Argument count from main()
+     * @param argv[in] Arguments from main()
+     */
+    static void setCommandLine(int argc, char* argv[]);
+
+    /**
+     * @brief Returns the cached resolved configuration of a file. Every load flattens, in increasing
+     *        precedence, the defaults of ConfigKeys.h, the file, the *.conf files of the include
+     *        directory <stem>.d next to it, CPPMS_<SECTION>__<KEY> environment variables and the
+     *        command line; ConfigSnapshot::lookup() tells which of them a value came from. The
+     *        sources are read again only when the file or the include directory changed inode,
+     *        mtime or size; the stat() check itself runs at most once per STAT_CHECK_INTERVAL, so
+     *        hot-path reads are a mutex and a hash lookup
+     * @param filename[in] Path to the configuration file
+     * @return Shared immutable snapshot, stays valid for the caller even if the file is reloaded
+     */
+    static std::shared_ptr<const ConfigSnapshot> getSnapshot(const std::string& filename);
+
+    /**
+     * @brief Parses the file now regardless of the stat check and replaces the cached snapshot,
+     *        used by ConfigWatcher when inotify reports a change
+     * @param filename[in] Path to the configuration file
+     * @return The freshly parsed snapshot
+     */
+    static std::shared_ptr<const ConfigSnapshot> reload(const std::string& filename);
+
     /**
      * @brief Reads all sections and their key-value pairs from a configuration file
      * @param filename[in] Path to the configuration file
@@ -73,23 +109,64 @@ public:
                           const std::string& key,
                           const std::string& value);
 
+    /**
+     * @brief Applies many section/key updates with one parse, one write and one atomic rename.
+     *        Writers of the same file, in this or other processes, are serialized by an advisory
+     *        flock() on <file>.lock; readers never see a partially written file
+     * @param filename[in] Path to the configuration file, created if it does not exist
+     * @param updates[in] Values to set, keyed by section then key; other keys are kept as they are
+     * @return True if the new file was written and synced, false if the old file is unchanged
+     */
+    static bool writeConfigBatch(const std::string& filename,
+                                 const std::map<std::string, std::map<std::string, std::string>>& updates);
+
+    /**
+     * @brief Compiles the configuration file itself, without defaults, includes or overrides, into a
+     *        checksummed binary image <file>.bin next to it. Later loads map that image instead of
+     *        parsing the file as long as it is at least as new as the file and records the file's
+     *        current inode, size and mtime; otherwise they parse the file as usual. With [Config]
+     *        binary_cache=true every load that had to parse the file compiles it again
+     * @param filename[in] Path to the configuration file
+     * @return True if the image was written and renamed into place
+     */
+    static bool compileConfig(const std::string& filename);
+
 private:
     /**
-     * @brief Creates a backup copy of the configuration file
-     * @param filename[in] Path to the configuration file to backup
-     * @return True if backup was successful, false otherwise
+     * @brief Drops the cached snapshot so the next read parses the file again
+     * @param filename[in] Path to the configuration file
+     */
+    static void invalidateCache(const std::string& filename);
+
+    /**
+     * @brief Reads every source of a configuration and flattens them into a snapshot
+     * @param filename[in] Path to the configuration file to parse
+     * @return Freshly resolved snapshot, not stored in the cache
+     */
+    static std::shared_ptr<const ConfigSnapshot> loadSnapshot(const std::string& filename);
+
+    /**
+     * @brief The environment and command line layers, empty if neither sets anything
+     */
+    static std::vector<ConfigLayer> overrideLayers();
+
+    /**
+     * @brief Get the compiled image path, config.conf -> config.conf.bin next to it
+     * @param filename 
+     * @return std::filesystem::path 
      */
-    static bool makeBackup(const std::string& filename);
+    static std::filesystem::path getCompiledPath(const std::string& filename);
 
     /**
-     * @brief Restores configuration file from its backup
-     * @param filename[in] Path to the configuration file to restore
-     * @return True if restoration was successful, false otherwise
+     * @brief Get the include directory, config.conf -> config.d next to it
+     * @param filename 
+     * @return std::filesystem::path 
      */
-    static bool restoreFromBackup(const std::string& filename);
+    static std::filesystem::path getIncludeDir(const std::string& filename);
 
     /**
-     * @brief Parses a configuration file into a structured map
+     * @brief Parses only the configuration file itself into a structured map, without defaults
+     *        or overrides, so writing it back does not copy them into the file
      * @param filename[in] Path to the configuration file to parse
      * @return Map containing parsed configuration data
      */
@@ -97,7 +174,8 @@ private:
     parseConfigFile(const std::string& filename);
 
     /**
-     * @brief Writes configuration data to a file
+     * @brief Writes configuration data to a temporary file, fsyncs it, renames it over the file and
+     *        fsyncs the directory so the rename itself survives a crash
      * @param filename[in] Path to the configuration file to write
      * @param config[in] Configuration data to write
      * @return True if write operation was successful, false otherwise
@@ -113,13 +191,6 @@ private:
      */
     static std::filesystem::path getConfigPath(const std::string& filename);
 
-    /**
-     * @brief Get the Backup Path object
-     * @param filename 
-     * @return std::filesystem::path 
-     */
-    static std::filesystem::path getBackupPath(const std::string& filename);
-
     /**
      * @brief Check if the path is valid
      * 
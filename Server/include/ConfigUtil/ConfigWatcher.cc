@@ -0,0 +1,274 @@
+#include "ConfigWatcher.h"
+#include "ConfigUtil.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <chrono>
+#include <iostream>
+#include <set>
+#include <string_view>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+// 监视线程检查停止标志的间隔
+static const int POLL_INTERVAL_MS = 200;
+
+ConfigWatcher::ConfigWatcher(const std::string& filename, bool use_guardian_snapshot)
+    : filename(filename)
+    , next_id(0)
+    , inotify_fd(-1)
+    , dir_wd(-1)
+    , include_wd(-1)
+    , use_guardian_snapshot(use_guardian_snapshot)
+    , shared_generation(0)
+    , running(false) {}
+
+ConfigWatcher::~ConfigWatcher() {
+    stop();
+}
+
+bool ConfigWatcher::start() {
+    if (running) {
+        return true;
+    }
+
+    if (use_guardian_snapshot) {
+        shared = std::make_unique<SharedConfigReader>();
+        if (shared->attach()) {
+            reloadShared();
+            running = true;
+            worker = std::thread(&ConfigWatcher::runShared, this);
+            return true;
+        }
+        std::cout << "No shared config from Guardian, reading " << filename << " directly" << std::endl;
+        shared.reset();
+    }
+    reload();
+
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd == -1) {
+        std::cerr << "Failed to create inotify instance: " << strerror(errno) << std::endl;
+        return false;
+    }
+    // 监视所在目录而不是文件本身:rename替换文件后,文件上的watch会跟着旧inode失效
+    std::string dir = ConfigManager::getConfigPath(filename).parent_path().string();
+    dir_wd = inotify_add_watch(inotify_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (dir_wd == -1) {
+        std::cerr << "Failed to watch " << dir << ": " << strerror(errno) << std::endl;
+        close(inotify_fd);
+        inotify_fd = -1;
+        return false;
+    }
+    watchIncludeDir();
+
+    running = true;
+    worker = std::thread(&ConfigWatcher::run, this);
+    return true;
+}
+
+void ConfigWatcher::stop() {
+    running = false;
+    if (worker.joinable()) {
+        worker.join();
+    }
+    if (inotify_fd != -1) {
+        close(inotify_fd);
+        inotify_fd = -1;
+    }
+}
+
+std::shared_ptr<const ConfigSnapshot> ConfigWatcher::current() const {
+    return std::atomic_load(&snapshot);
+}
+
+int ConfigWatcher::subscribe(const std::string& section, Callback cb) {
+    int id;
+    {
+        std::lock_guard<std::mutex> lock(subscribers_mtx);
+        id = next_id++;
+        subscribers.push_back({id, section, cb});
+    }
+    if (auto loaded = current()) {
+        cb(*loaded);
+    }
+    return id;
+}
+
+void ConfigWatcher::unsubscribe(int id) {
+    std::lock_guard<std::mutex> lock(subscribers_mtx);
+    for (auto it = subscribers.begin(); it != subscribers.end(); ++it) {
+        if (it->id == id) {
+            subscribers.erase(it);
+            return;
+        }
+    }
+}
+
+void ConfigWatcher::watchIncludeDir() {
+    std::string dir = ConfigManager::getIncludeDir(filename).string();
+    int wd = inotify_add_watch(inotify_fd, dir.c_str(),
+                               IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_MOVE_SELF);
+    if (wd != -1) {
+        include_wd = wd;
+    }
+}
+
+void ConfigWatcher::run() {
+    std::string name = ConfigManager::getConfigPath(filename).filename().string();
+    std::string include_name = ConfigManager::getIncludeDir(filename).filename().string();
+    alignas(inotify_event) char buffer[4096];
+
+    while (running) {
+        pollfd pfd{inotify_fd, POLLIN, 0};
+        int ready = poll(&pfd, 1, POLL_INTERVAL_MS);
+        if (ready == -1 && errno != EINTR) {
+            std::cerr << "Config watcher poll() failed: " << strerror(errno) << std::endl;
+            break;
+        }
+        if (ready <= 0) {
+            continue;
+        }
+
+        // 一次取完所有事件,同一文件的多次写入只重新加载一次
+        bool changed = false;
+        ssize_t n;
+        while ((n = read(inotify_fd, buffer, sizeof(buffer))) > 0) {
+            for (char* p = buffer; p < buffer + n; ) {
+                auto* event = reinterpret_cast<inotify_event*>(p);
+                std::string_view entry = event->len > 0 ? std::string_view(event->name) : std::string_view();
+                if (event->mask & IN_Q_OVERFLOW) {
+                    // 事件队列溢出时不知道丢了哪些事件,重新加载;包含目录的创建也可能在其中
+                    if (include_wd == -1) {
+                        watchIncludeDir();
+                    }
+                    changed = true;
+                } else if (event->wd == include_wd && (event->mask & IN_MOVE_SELF)) {
+                    // 包含目录被移走,watch会跟着旧目录;移除它,随后的IN_IGNORED按删除处理
+                    inotify_rm_watch(inotify_fd, include_wd);
+                    changed = true;
+                } else if (event->wd == include_wd && (event->mask & IN_IGNORED)) {
+                    // 包含目录被删除,watch已失效;若已经重新创建就立刻重新监视,否则等目录里出现它的IN_CREATE
+                    include_wd = -1;
+                    watchIncludeDir();
+                    changed = true;
+                } else if (event->wd == dir_wd && entry == name && (event->mask & IN_CREATE) == 0) {
+                    changed = true;
+                } else if (event->wd == dir_wd && entry == include_name) {
+                    // 包含目录是后来创建或移入的
+                    watchIncludeDir();
+                    changed = true;
+                } else if (event->wd == include_wd && entry.size() > 5
+                           && entry.compare(entry.size() - 5, 5, ".conf") == 0) {
+                    changed = true;
+                }
+                p += sizeof(inotify_event) + event->len;
+            }
+        }
+        if (changed) {
+            reload();
+        }
+    }
+}
+
+void ConfigWatcher::runShared() {
+    // 只比较代数,一次acquire读取
+    while (running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL_MS));
+        if (shared->generation() != shared_generation) {
+            reloadShared();
+        }
+    }
+}
+
+void ConfigWatcher::reloadShared() {
+    uint64_t generation = 0;
+    auto next = shared->load(generation);
+    if (!next) {
+        // 镜像无效时记下代数,避免每个周期重复尝试同一代
+        shared_generation = shared->generation();
+        return;
+    }
+    shared_generation = generation;
+
+    // 本进程自己的环境变量和命令行覆盖叠加在Guardian的快照之上,没有时直接使用映射
+    auto overrides = ConfigManager::overrideLayers();
+    if (!overrides.empty()) {
+        next = std::make_shared<const ConfigSnapshot>(std::move(overrides), std::move(next));
+    }
+    for (const auto& error : next->errors()) {
+        std::cerr << "Config " << filename << ": " << error << std::endl;
+    }
+    publish(std::move(next));
+}
+
+void ConfigWatcher::reload() {
+    std::shared_ptr<const ConfigSnapshot> next;
+    try {
+        next = ConfigManager::reload(filename);
+    } catch (const std::exception& e) {
+        std::cerr << "Config reload failed, keeping previous values: " << e.what() << std::endl;
+        return;
+    }
+
+    for (const auto& error : next->errors()) {
+        std::cerr << "Config " << filename << ": " << error << std::endl;
+    }
+
+    publish(std::move(next));
+}
+
+void ConfigWatcher::publish(std::shared_ptr<const ConfigSnapshot> next) {
+    auto previous = std::atomic_load(&snapshot);
+    std::atomic_store(&snapshot, next);
+    notify(previous.get(), *next);
+}
+
+void ConfigWatcher::notify(const ConfigSnapshot* previous, const ConfigSnapshot& next) {
+    // 复制一份再回调,回调中可以再订阅或取消订阅
+    std::vector<Subscriber> targets;
+    {
+        std::lock_guard<std::mutex> lock(subscribers_mtx);
+        targets = subscribers;
+    }
+
+    std::set<std::string> checked;
+    std::set<std::string> changed;
+    for (const auto& subscriber : targets) {
+        if (checked.insert(subscriber.section).second) {
+            ConfigSnapshot::Range before{};
+            ConfigSnapshot::Range after{};
+            if (subscriber.section.empty()) {
+                // 空节名订阅整个配置
+                if (previous != nullptr) {
+                    before = {previous->entries().data(), previous->entries().data() + previous->entries().size()};
+                }
+                after = {next.entries().data(), next.entries().data() + next.entries().size()};
+            } else {
+                if (previous != nullptr) {
+                    before = previous->section(subscriber.section);
+                }
+                after = next.section(subscriber.section);
+            }
+            bool same = before.size() == after.size()
+                && std::equal(before.begin(), before.end(), after.begin(),
+                              [](const ConfigSnapshot::Entry& a, const ConfigSnapshot::Entry& b) {
+                                  return a.section == b.section && a.key == b.key && a.value == b.value;
+                              });
+            // 首次加载时所有订阅者都会收到一次
+            if (previous == nullptr || !same) {
+                changed.insert(subscriber.section);
+            }
+        }
+        if (changed.count(subscriber.section) == 0) {
+            continue;
+        }
+        try {
+            subscriber.cb(next);
+        } catch (const std::exception& e) {
+            std::cerr << "Config subscriber for [" << subscriber.section << "] failed: " << e.what() << std::endl;
+        }
+    }
+}
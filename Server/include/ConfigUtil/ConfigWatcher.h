@@ -0,0 +1,124 @@
+/**
+ * @file ConfigWatcher.h
+ * @author KevinGlaser
+ * @brief Reloads a config file when it changes on disk and notifies per-section subscribers
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef __CONFIGWATCHER_H__
+#define __CONFIGWATCHER_H__
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ConfigSnapshot.h"
+#include "SharedConfig.h"
+
+/**
+ * @brief Watches the directory of a config file with inotify. Editors and ConfigManager::writeConfig
+ *        replace the file by rename, which a watch on the file itself would lose, so the watch is on
+ *        the directory and filtered by name; the include directory (ConfigManager::getConfigPath
+ *        with .d) is watched as well. On a change the watcher thread parses the file, publishes
+ *        the new ConfigSnapshot with an atomic shared_ptr store and calls the subscribers of every
+ *        section whose values differ from the previous snapshot. Readers call current() and never
+ *        take the subscriber lock; a snapshot they hold stays valid after a swap.
+ *
+ *        With use_guardian_snapshot the watcher first tries the snapshot the Guardian publishes in
+ *        shared memory (SharedConfig.h): it maps each generation instead of parsing the file and
+ *        polls the generation counter every POLL_INTERVAL_MS. This process's own environment and
+ *        command line overrides still apply on top of it. Without a publishing Guardian it falls
+ *        back to watching the file itself.
+ */
+class ConfigWatcher {
+public:
+    using Callback = std::function<void(const ConfigSnapshot&)>;
+
+    explicit ConfigWatcher(const std::string& filename, bool use_guardian_snapshot = false);
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    /**
+     * @brief load the file, call every subscriber once with it and start watching
+     *
+     * @return true watching
+     * @return false inotify could not be set up, current() still holds the initial load if it succeeded
+     */
+    bool start();
+
+    /**
+     * @brief stop the watcher thread, current() keeps the last snapshot
+     */
+    void stop();
+
+    /**
+     * @brief latest successfully parsed snapshot, nullptr before the first successful load
+     */
+    std::shared_ptr<const ConfigSnapshot> current() const;
+
+    /**
+     * @brief call cb from the watcher thread whenever a key of section is added, removed or changed,
+     *        an empty section means any change. If a snapshot is already loaded cb is also called
+     *        once right away with it.
+     *
+     * @return id for unsubscribe()
+     */
+    int subscribe(const std::string& section, Callback cb);
+    void unsubscribe(int id);
+
+private:
+    struct Subscriber {
+        int id;
+        std::string section;
+        Callback cb;
+    };
+
+    void run();
+    void runShared();
+
+    /**
+     * @brief parse the file and publish it, a parse failure keeps the previous snapshot
+     */
+    void reload();
+
+    /**
+     * @brief map the Guardian's current generation and publish it
+     */
+    void reloadShared();
+
+    void publish(std::shared_ptr<const ConfigSnapshot> next);
+
+    /**
+     * @brief watch the include directory if it exists, called again when it is created or moved in
+     *        and after its watch was dropped because the directory was deleted or moved away
+     */
+    void watchIncludeDir();
+
+    void notify(const ConfigSnapshot* previous, const ConfigSnapshot& next);
+
+    std::string filename;
+    std::shared_ptr<const ConfigSnapshot> snapshot;     // 只通过std::atomic_load/atomic_store访问
+    std::mutex subscribers_mtx;
+    std::vector<Subscriber> subscribers;
+    int next_id;
+    int inotify_fd;
+    int dir_wd;
+    int include_wd;
+    bool use_guardian_snapshot;
+    std::unique_ptr<SharedConfigReader> shared;
+    uint64_t shared_generation;
+    std::atomic<bool> running;
+    std::thread worker;
+};
+
+#endif
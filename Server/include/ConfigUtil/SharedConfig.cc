@@ -0,0 +1,217 @@
+#include "SharedConfig.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SharedConfigPublisher::SharedConfigPublisher() : control_(nullptr), generation_(0) {
+    int fd = shm_open(sharedconfig::CONTROL_NAME, O_CREAT | O_RDWR, 0644);
+    if (fd == -1) {
+        std::cerr << "Failed to create " << sharedconfig::CONTROL_NAME << ": " << strerror(errno) << std::endl;
+        return;
+    }
+    if (ftruncate(fd, sizeof(sharedconfig::Control)) != 0) {
+        std::cerr << "Failed to size " << sharedconfig::CONTROL_NAME << ": " << strerror(errno) << std::endl;
+        close(fd);
+        return;
+    }
+    void* addr = mmap(nullptr, sizeof(sharedconfig::Control), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        std::cerr << "Failed to map " << sharedconfig::CONTROL_NAME << ": " << strerror(errno) << std::endl;
+        return;
+    }
+
+    control_ = static_cast<sharedconfig::Control*>(addr);
+    if (memcmp(control_->magic, sharedconfig::MAGIC, sizeof(sharedconfig::MAGIC)) == 0
+        && control_->version == sharedconfig::FORMAT_VERSION) {
+        // 上一个Guardian遗留的控制段,代数继续递增,仍在运行的服务端能看到变化
+        generation_ = control_->generation.load(std::memory_order_acquire);
+    } else {
+        control_ = new (addr) sharedconfig::Control();
+        control_->version = sharedconfig::FORMAT_VERSION;
+        control_->generation.store(0, std::memory_order_relaxed);
+        // magic最后写入,读端看到magic时其余字段已经有效
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(control_->magic, sharedconfig::MAGIC, sizeof(sharedconfig::MAGIC));
+    }
+    std::cout << "SharedConfigPublisher" << std::endl << std::flush;
+}
+
+SharedConfigPublisher::~SharedConfigPublisher() {
+    if (control_ != nullptr) {
+        munmap(control_, sizeof(sharedconfig::Control));
+        shm_unlink(sharedconfig::ImageName(generation_).c_str());
+        shm_unlink(sharedconfig::CONTROL_NAME);
+    }
+    std::cout << "~SharedConfigPublisher" << std::endl << std::flush;
+}
+
+bool SharedConfigPublisher::publish(const ConfigSnapshot& snapshot) {
+    if (control_ == nullptr) {
+        return false;
+    }
+
+    uint64_t next = generation_ + 1;
+    std::string name = sharedconfig::ImageName(next);
+    if (!writeImage(name, snapshot, next)) {
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    // 新镜像完整写好后才切换代数;旧镜像unlink后,已映射它的服务端仍可继续读取
+    control_->generation.store(next, std::memory_order_release);
+    if (generation_ != 0) {
+        shm_unlink(sharedconfig::ImageName(generation_).c_str());
+    }
+    generation_ = next;
+    return true;
+}
+
+bool SharedConfigPublisher::writeImage(const std::string& name, const ConfigSnapshot& snapshot,
+                                       uint64_t generation) {
+    configimage::Body body;
+    if (!configimage::Encode(snapshot.entries(), body)) {
+        std::cerr << "Config too large to publish: " << body.text.size() << " bytes" << std::endl;
+        return false;
+    }
+
+    sharedconfig::ImageHeader header{};
+    memcpy(header.magic, sharedconfig::MAGIC, sizeof(sharedconfig::MAGIC));
+    header.version = sharedconfig::FORMAT_VERSION;
+    header.entry_count = static_cast<uint32_t>(body.table.size());
+    header.generation = generation;
+    header.text_size = body.text.size();
+    size_t size = sizeof(header) + body.table.size() * sizeof(configimage::Record) + body.text.size();
+
+    // 崩溃遗留的同名段先删除,保证镜像只被写入一次
+    shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd == -1) {
+        std::cerr << "Failed to create " << name << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        std::cerr << "Failed to size " << name << ": " << strerror(errno) << std::endl;
+        close(fd);
+        return false;
+    }
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        std::cerr << "Failed to map " << name << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    char* p = static_cast<char*>(addr);
+    memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    if (!body.table.empty()) {
+        memcpy(p, body.table.data(), body.table.size() * sizeof(configimage::Record));
+        p += body.table.size() * sizeof(configimage::Record);
+    }
+    memcpy(p, body.text.data(), body.text.size());
+    munmap(addr, size);
+    return true;
+}
+
+SharedConfigReader::SharedConfigReader() : control_(nullptr) {}
+
+SharedConfigReader::~SharedConfigReader() {
+    if (control_ != nullptr) {
+        munmap(const_cast<sharedconfig::Control*>(control_), sizeof(sharedconfig::Control));
+    }
+}
+
+bool SharedConfigReader::attach() {
+    if (control_ != nullptr) {
+        return true;
+    }
+    int fd = shm_open(sharedconfig::CONTROL_NAME, O_RDONLY, 0);
+    if (fd == -1) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(sharedconfig::Control)) {
+        close(fd);
+        return false;
+    }
+    void* addr = mmap(nullptr, sizeof(sharedconfig::Control), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+
+    auto* control = static_cast<const sharedconfig::Control*>(addr);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (memcmp(control->magic, sharedconfig::MAGIC, sizeof(sharedconfig::MAGIC)) != 0
+        || control->version != sharedconfig::FORMAT_VERSION) {
+        munmap(addr, sizeof(sharedconfig::Control));
+        return false;
+    }
+    control_ = control;
+    return true;
+}
+
+uint64_t SharedConfigReader::generation() const {
+    return control_ == nullptr ? 0 : control_->generation.load(std::memory_order_acquire);
+}
+
+std::shared_ptr<const ConfigSnapshot> SharedConfigReader::load(uint64_t& generation) const {
+    // 读到代数后Guardian可能已发布下一代并删除了这一代,重新读取代数再试
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        uint64_t current = this->generation();
+        if (current == 0) {
+            return nullptr;
+        }
+        std::string name = sharedconfig::ImageName(current);
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd == -1) {
+            if (errno == ENOENT) {
+                continue;
+            }
+            std::cerr << "Failed to open " << name << ": " << strerror(errno) << std::endl;
+            return nullptr;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            close(fd);
+            return nullptr;
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        void* addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED) {
+            std::cerr << "Failed to map " << name << ": " << strerror(errno) << std::endl;
+            return nullptr;
+        }
+
+        auto* header = static_cast<const sharedconfig::ImageHeader*>(addr);
+        if (!sharedconfig::Valid(header, size) || header->generation != current) {
+            std::cerr << "Invalid shared config image " << name << std::endl;
+            munmap(addr, size);
+            return nullptr;
+        }
+
+        std::vector<ConfigSnapshot::Entry> entries;
+        if (!configimage::Decode(sharedconfig::Entries(header), header->entry_count, sharedconfig::Text(header),
+                                 header->text_size, entries)) {
+            std::cerr << "Invalid shared config image " << name << std::endl;
+            munmap(addr, size);
+            return nullptr;
+        }
+
+        // 快照持有映射,最后一个引用释放时才解除映射
+        std::shared_ptr<const void> storage(addr, [size](const void* p) { munmap(const_cast<void*>(p), size); });
+        generation = current;
+        return std::make_shared<const ConfigSnapshot>(std::move(storage), std::move(entries));
+    }
+    return nullptr;
+}
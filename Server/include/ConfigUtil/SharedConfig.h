@@ -0,0 +1,88 @@
+/**
+ * @file SharedConfig.h
+ * @author KevinGlaser
+ * @brief Publishes a parsed config to shared memory (Guardian) and maps it without parsing (Server)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef __SHAREDCONFIG_H__
+#define __SHAREDCONFIG_H__
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "ConfigSnapshot.h"
+#include "SharedConfigFormat.h"
+
+/**
+ * @brief Guardian side. Owns the control segment and the image of the current generation, both are
+ *        unlinked on destruction. publish() is called from a single thread.
+ */
+class SharedConfigPublisher {
+public:
+    SharedConfigPublisher();
+    ~SharedConfigPublisher();
+
+    SharedConfigPublisher(const SharedConfigPublisher&) = delete;
+    SharedConfigPublisher& operator=(const SharedConfigPublisher&) = delete;
+
+    /**
+     * @brief write snapshot as the next generation and make it current
+     *
+     * @return false the control segment or the image could not be created, Servers keep the
+     *         previous generation
+     */
+    bool publish(const ConfigSnapshot& snapshot);
+
+    uint64_t generation() const { return generation_; }
+
+private:
+    bool writeImage(const std::string& name, const ConfigSnapshot& snapshot, uint64_t generation);
+
+    sharedconfig::Control* control_;
+    uint64_t generation_;
+};
+
+/**
+ * @brief Server side. Maps the control segment read-only; generation() is one acquire load, load()
+ *        maps the current image and wraps it in a ConfigSnapshot whose entries point into the
+ *        mapping, so no text is copied or parsed.
+ */
+class SharedConfigReader {
+public:
+    SharedConfigReader();
+    ~SharedConfigReader();
+
+    SharedConfigReader(const SharedConfigReader&) = delete;
+    SharedConfigReader& operator=(const SharedConfigReader&) = delete;
+
+    /**
+     * @brief map the control segment
+     *
+     * @return false no Guardian is publishing a config
+     */
+    bool attach();
+
+    /**
+     * @brief generation published last, 0 if none or not attached
+     */
+    uint64_t generation() const;
+
+    /**
+     * @brief map the current image
+     *
+     * @param generation[out] generation of the returned snapshot
+     * @return nullptr if nothing is published or the image is invalid
+     */
+    std::shared_ptr<const ConfigSnapshot> load(uint64_t& generation) const;
+
+private:
+    const sharedconfig::Control* control_;
+};
+
+#endif
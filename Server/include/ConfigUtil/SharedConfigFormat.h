@@ -0,0 +1,79 @@
+/**
+ * @file SharedConfigFormat.h
+ * @author KevinGlaser
+ * @brief Layout of the config snapshot the Guardian publishes in shared memory for the Servers
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef __SHAREDCONFIGFORMAT_H__
+#define __SHAREDCONFIGFORMAT_H__
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "ConfigImage.h"
+
+/**
+ * The control segment /cpp_multiserver_config holds only the current generation. Every published
+ * generation N is a separate segment /cpp_multiserver_config_<N> that is written once and never
+ * modified: an ImageHeader followed by a ConfigImage.h body of entry_count records and text_size
+ * bytes of text, including where each value came from. The Guardian
+ * creates image N completely, then stores N into the control segment with release ordering, then
+ * unlinks image N-1. A Server that loaded N with acquire opens the image by name and maps it
+ * read-only; a mapping outlives the unlink, so a snapshot keeps reading its own image however many
+ * reloads happen meanwhile. Generation 0 means nothing was published yet.
+ */
+namespace sharedconfig {
+
+constexpr char MAGIC[8] = {'C', 'M', 'S', 'C', 'O', 'N', 'F', '1'};
+constexpr uint32_t FORMAT_VERSION = 2;
+constexpr char CONTROL_NAME[] = "/cpp_multiserver_config";
+
+struct Control {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    std::atomic<uint64_t> generation;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared config needs lock free 64 bit atomics");
+
+struct ImageHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_count;
+    uint64_t generation;
+    uint64_t text_size;
+};
+
+inline std::string ImageName(uint64_t generation) {
+    return std::string(CONTROL_NAME) + "_" + std::to_string(generation);
+}
+
+inline const configimage::Record* Entries(const ImageHeader* header) {
+    return reinterpret_cast<const configimage::Record*>(header + 1);
+}
+
+inline const char* Text(const ImageHeader* header) {
+    return reinterpret_cast<const char*>(Entries(header) + header->entry_count);
+}
+
+// 只检查头部和各区大小,记录的偏移由configimage::Decode()检查
+inline bool Valid(const ImageHeader* header, size_t mapped_size) {
+    if (mapped_size < sizeof(ImageHeader) || memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0
+        || header->version != FORMAT_VERSION) {
+        return false;
+    }
+    uint64_t table = sizeof(ImageHeader) + static_cast<uint64_t>(header->entry_count) * sizeof(configimage::Record);
+    return table <= mapped_size && header->text_size <= mapped_size - table;
+}
+
+} // namespace sharedconfig
+
+#endif
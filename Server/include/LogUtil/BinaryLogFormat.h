@@ -0,0 +1,254 @@
+/**
+ * @file BinaryLogFormat.h
+ * @author KevinGlaser
+ * @brief Layout of binary log segments and their index, shared by BinaryLogHandler and logdecode
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef __BINARYLOGFORMAT_H__
+#define __BINARYLOGFORMAT_H__
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "LogUtil.h"
+
+/**
+ * A segment file <base>.<n>.blog is a SegmentHeader followed by records. All integers are in
+ * host byte order, the files are meant to be decoded on the machine that wrote them.
+ *
+ * record:
+ *     u32 length          whole record including this field
+ *     u32 source_id
+ *     u64 timestamp_ns    since the unix epoch
+ *     u64 thread_id
+ *     u8  level
+ *     u8  field_count
+ *     u16 reserved
+ *     u32 message_len
+ *     message bytes
+ *     field_count x { u8 type, u8 name_len, name bytes, value }
+ *         value: 8 bytes for INT64/UINT64/DOUBLE, 1 byte for BOOL, u32 len + bytes for STRING
+ *
+ * When a segment is closed its index is written next to it as <base>.<n>.blog.idx: an
+ * IndexHeader followed by one IndexEntry per INDEX_STRIDE records, so a reader can skip whole
+ * segments and blocks by time range or level without decoding them. Segments without an index
+ * (the one being written, or after a crash) are scanned from the start.
+ */
+namespace binlog {
+
+constexpr char SEGMENT_MAGIC[8] = {'C', 'M', 'S', 'B', 'L', 'O', 'G', '1'};
+constexpr char INDEX_MAGIC[8] = {'C', 'M', 'S', 'B', 'I', 'D', 'X', '1'};
+constexpr uint32_t FORMAT_VERSION = 1;
+constexpr size_t RECORD_HEADER_SIZE = 32;
+constexpr size_t INDEX_STRIDE = 256;
+
+// 与LogField::Value中的类型顺序一致
+enum FieldType : uint8_t {
+    FIELD_INT64 = 0,
+    FIELD_UINT64 = 1,
+    FIELD_DOUBLE = 2,
+    FIELD_BOOL = 3,
+    FIELD_STRING = 4
+};
+
+struct SegmentHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+};
+
+struct IndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t level_mask;        // bit (1 << level) set if the segment holds that level
+    uint64_t min_timestamp_ns;
+    uint64_t max_timestamp_ns;
+    uint64_t record_count;
+    uint64_t entry_count;
+};
+
+struct IndexEntry {
+    uint64_t offset;            // file offset of the first record of the block
+    uint64_t min_timestamp_ns;
+    uint64_t max_timestamp_ns;
+    uint32_t level_mask;
+    uint32_t record_count;
+};
+
+struct DecodedField {
+    std::string_view name;
+    FieldType type;
+    int64_t i64;
+    uint64_t u64;
+    double f64;
+    bool boolean;
+    std::string_view str;
+};
+
+struct DecodedRecord {
+    uint64_t timestamp_ns;
+    uint64_t thread_id;
+    uint32_t source_id;
+    uint8_t level;
+    std::string_view message;
+    std::vector<DecodedField> fields;
+};
+
+template<typename T>
+inline void Put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template<typename T>
+inline bool Get(const char*& p, const char* end, T& value) {
+    if (static_cast<size_t>(end - p) < sizeof(value)) {
+        return false;
+    }
+    memcpy(&value, p, sizeof(value));
+    p += sizeof(value);
+    return true;
+}
+
+inline uint64_t ToNanoseconds(std::chrono::system_clock::time_point tp) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count());
+}
+
+// 与文本日志中打印的线程id一致(glibc下std::thread::id即pthread_t),其他实现退化为哈希值
+inline uint64_t ThreadIdToInt(std::thread::id id) {
+    if constexpr (sizeof(id) == sizeof(uint64_t)) {
+        uint64_t value;
+        memcpy(&value, &id, sizeof(value));
+        return value;
+    } else {
+        return static_cast<uint64_t>(std::hash<std::thread::id>()(id));
+    }
+}
+
+/**
+ * @brief append one encoded record to out
+ */
+inline void EncodeRecord(std::string& out, uint64_t timestamp_ns, uint64_t thread_id, uint32_t source_id,
+                         uint8_t level, std::string_view message, const std::vector<LogField>& fields) {
+    size_t start = out.size();
+    Put<uint32_t>(out, 0);                  // length, patched below
+    Put<uint32_t>(out, source_id);
+    Put<uint64_t>(out, timestamp_ns);
+    Put<uint64_t>(out, thread_id);
+    Put<uint8_t>(out, level);
+    Put<uint8_t>(out, static_cast<uint8_t>(std::min<size_t>(fields.size(), UINT8_MAX)));
+    Put<uint16_t>(out, 0);
+    Put<uint32_t>(out, static_cast<uint32_t>(message.size()));
+    out.append(message.data(), message.size());
+
+    for (size_t i = 0; i < fields.size() && i < UINT8_MAX; ++i) {
+        const LogField& field = fields[i];
+        size_t name_len = std::min<size_t>(field.name.size(), UINT8_MAX);
+        Put<uint8_t>(out, static_cast<uint8_t>(field.value.index()));
+        Put<uint8_t>(out, static_cast<uint8_t>(name_len));
+        out.append(field.name.data(), name_len);
+        switch (field.value.index()) {
+            case FIELD_INT64: Put<int64_t>(out, std::get<int64_t>(field.value)); break;
+            case FIELD_UINT64: Put<uint64_t>(out, std::get<uint64_t>(field.value)); break;
+            case FIELD_DOUBLE: Put<double>(out, std::get<double>(field.value)); break;
+            case FIELD_BOOL: Put<uint8_t>(out, std::get<bool>(field.value) ? 1 : 0); break;
+            default: {
+                const std::string& str = std::get<std::string>(field.value);
+                Put<uint32_t>(out, static_cast<uint32_t>(str.size()));
+                out.append(str);
+                break;
+            }
+        }
+    }
+
+    uint32_t length = static_cast<uint32_t>(out.size() - start);
+    memcpy(&out[start], &length, sizeof(length));
+}
+
+inline void EncodeRecord(std::string& out, const LogRecord& record) {
+    EncodeRecord(out, ToNanoseconds(record.timestamp), ThreadIdToInt(record.thread_id), record.source_id,
+                 static_cast<uint8_t>(record.level), record.body, record.fields);
+}
+
+/**
+ * @brief decode the record starting at p, the views point into the caller's buffer
+ * @return size of the record, 0 if the bytes at p are not a complete record
+ */
+inline size_t DecodeRecord(const char* p, const char* end, DecodedRecord& record) {
+    const char* begin = p;
+    uint32_t length = 0;
+    if (!Get(p, end, length) || length < RECORD_HEADER_SIZE || length > static_cast<size_t>(end - begin)) {
+        return 0;
+    }
+    end = begin + length;
+
+    uint8_t field_count = 0;
+    uint16_t reserved = 0;
+    uint32_t message_len = 0;
+    Get(p, end, record.source_id);
+    Get(p, end, record.timestamp_ns);
+    Get(p, end, record.thread_id);
+    Get(p, end, record.level);
+    Get(p, end, field_count);
+    Get(p, end, reserved);
+    Get(p, end, message_len);
+    if (message_len > static_cast<size_t>(end - p)) {
+        return 0;
+    }
+    record.message = std::string_view(p, message_len);
+    p += message_len;
+
+    record.fields.clear();
+    for (uint8_t i = 0; i < field_count; ++i) {
+        DecodedField field{};
+        uint8_t type = 0;
+        uint8_t name_len = 0;
+        if (!Get(p, end, type) || !Get(p, end, name_len) || name_len > end - p) {
+            return 0;
+        }
+        field.type = static_cast<FieldType>(type);
+        field.name = std::string_view(p, name_len);
+        p += name_len;
+
+        bool ok = true;
+        switch (field.type) {
+            case FIELD_INT64: ok = Get(p, end, field.i64); break;
+            case FIELD_UINT64: ok = Get(p, end, field.u64); break;
+            case FIELD_DOUBLE: ok = Get(p, end, field.f64); break;
+            case FIELD_BOOL: {
+                uint8_t b = 0;
+                ok = Get(p, end, b);
+                field.boolean = (b != 0);
+                break;
+            }
+            case FIELD_STRING: {
+                uint32_t len = 0;
+                ok = Get(p, end, len) && len <= static_cast<size_t>(end - p);
+                if (ok) {
+                    field.str = std::string_view(p, len);
+                    p += len;
+                }
+                break;
+            }
+            default: ok = false; break;
+        }
+        if (!ok) {
+            return 0;
+        }
+        record.fields.push_back(field);
+    }
+    return length;
+}
+
+} // namespace binlog
+
+#endif
@@ -0,0 +1,155 @@
+#include <cerrno>
+#include <cstdio>
+#include <limits>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "BinaryLogHandler.h"
+
+static bool writeAll(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "write() failed: " << strerror(errno) << std::endl;
+            return false;
+        }
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+BinaryLogHandler::BinaryLogHandler(const std::string& base_path, size_t segment_size)
+    : base_path_(base_path)
+    , segment_size_(segment_size)
+    , next_seq_(1)
+    , fd_(-1)
+    , file_size_(0)
+    , index_header_{} {
+    openSegment();
+    std::cout << "BinaryLogHandler" << std::endl << std::flush;
+}
+
+BinaryLogHandler::~BinaryLogHandler() {
+    closeSegment();
+    std::cout << "~BinaryLogHandler" << std::endl << std::flush;
+}
+
+bool BinaryLogHandler::openSegment() {
+    for (;; ++next_seq_) {
+        segment_path_ = base_path_ + "." + std::to_string(next_seq_) + ".blog";
+        if (access(segment_path_.c_str(), F_OK) != 0) {
+            break;
+        }
+    }
+    ++next_seq_;
+
+    fd_ = open(segment_path_.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ == -1) {
+        std::cerr << "Failed to create log segment " << segment_path_ << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    binlog::SegmentHeader header{};
+    memcpy(header.magic, binlog::SEGMENT_MAGIC, sizeof(header.magic));
+    header.version = binlog::FORMAT_VERSION;
+    header.header_size = sizeof(header);
+    if (!writeAll(fd_, reinterpret_cast<const char*>(&header), sizeof(header))) {
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    file_size_ = sizeof(header);
+
+    index_header_ = binlog::IndexHeader{};
+    memcpy(index_header_.magic, binlog::INDEX_MAGIC, sizeof(index_header_.magic));
+    index_header_.version = binlog::FORMAT_VERSION;
+    index_header_.min_timestamp_ns = std::numeric_limits<uint64_t>::max();
+    index_.clear();
+    return true;
+}
+
+void BinaryLogHandler::closeSegment() {
+    Flush();
+    if (fd_ != -1) {
+        close(fd_);
+        fd_ = -1;
+        writeIndex();
+    }
+}
+
+void BinaryLogHandler::indexRecord(uint64_t offset, uint64_t timestamp_ns, LogLevel level) {
+    if (index_header_.record_count % binlog::INDEX_STRIDE == 0) {
+        index_.push_back({offset, timestamp_ns, timestamp_ns, 0, 0});
+    }
+    binlog::IndexEntry& entry = index_.back();
+    entry.min_timestamp_ns = std::min(entry.min_timestamp_ns, timestamp_ns);
+    entry.max_timestamp_ns = std::max(entry.max_timestamp_ns, timestamp_ns);
+    entry.level_mask |= 1u << level;
+    ++entry.record_count;
+
+    index_header_.min_timestamp_ns = std::min(index_header_.min_timestamp_ns, timestamp_ns);
+    index_header_.max_timestamp_ns = std::max(index_header_.max_timestamp_ns, timestamp_ns);
+    index_header_.level_mask |= 1u << level;
+    ++index_header_.record_count;
+}
+
+void BinaryLogHandler::writeIndex() {
+    if (index_.empty()) {
+        return;
+    }
+    index_header_.entry_count = index_.size();
+
+    std::string index_path = segment_path_ + ".idx";
+    std::string tmp_path = index_path + ".tmp";
+    int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        std::cerr << "Failed to create log index " << tmp_path << ": " << strerror(errno) << std::endl;
+        return;
+    }
+    bool ok = writeAll(fd, reinterpret_cast<const char*>(&index_header_), sizeof(index_header_))
+        && writeAll(fd, reinterpret_cast<const char*>(index_.data()), index_.size() * sizeof(binlog::IndexEntry));
+    close(fd);
+
+    if (!ok || std::rename(tmp_path.c_str(), index_path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+    }
+}
+
+void BinaryLogHandler::HandleLog(const std::string& message, LogLevel level) {
+    LogRecord record;
+    record.timestamp = std::chrono::system_clock::now();
+    record.thread_id = std::this_thread::get_id();
+    record.level = level;
+    record.source_id = 0;
+    record.queue_size = 0;
+    record.body = message;
+    HandleBatch(std::vector<LogRecord>(1, std::move(record)));
+}
+
+void BinaryLogHandler::HandleBatch(const std::vector<LogRecord>& batch) {
+    for (const auto& record : batch) {
+        if (fd_ != -1 && file_size_ + buffer_.size() >= segment_size_) {
+            closeSegment();
+            openSegment();
+        }
+        uint64_t offset = file_size_ + buffer_.size();
+        binlog::EncodeRecord(buffer_, record);
+        indexRecord(offset, binlog::ToNanoseconds(record.timestamp), record.level);
+    }
+    Flush();
+}
+
+void BinaryLogHandler::Flush() {
+    if (buffer_.empty()) {
+        return;
+    }
+    if (fd_ != -1 && writeAll(fd_, buffer_.data(), buffer_.size())) {
+        file_size_ += buffer_.size();
+    }
+    buffer_.clear();
+}
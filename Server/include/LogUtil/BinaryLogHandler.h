@@ -0,0 +1,53 @@
+/**
+ * @file BinaryLogHandler.h
+ * @author KevinGlaser
+ * @brief Log handler writing compact binary records with a per-segment index, decoded by logdecode
+ * @version 0.1
+ * @date 2026-10-19
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+
+#ifndef __BINARYLOGHANDLER_H__
+#define __BINARYLOGHANDLER_H__
+
+#include "BinaryLogFormat.h"
+
+/**
+ * @brief Writes <base>.<n>.blog segments (see BinaryLogFormat.h). Records are encoded straight
+ *        from the LogRecord fields, no text formatting happens, and each batch is written with a
+ *        single write(). A segment is closed and indexed once it reaches segment_size.
+ */
+class BinaryLogHandler : public LogHandler {
+public:
+    explicit BinaryLogHandler(const std::string& base_path, size_t segment_size = 64 * 1024 * 1024);
+    virtual ~BinaryLogHandler() override;
+
+    void HandleLog(const std::string& message, LogLevel level) override;
+    void HandleBatch(const std::vector<LogRecord>& batch) override;
+    void Flush() override;
+    bool NeedsFormattedText() const override { return false; }
+
+private:
+    bool openSegment();
+    void closeSegment();
+
+    /**
+     * @brief update the index for a record that will start at file offset
+     */
+    void indexRecord(uint64_t offset, uint64_t timestamp_ns, LogLevel level);
+    void writeIndex();
+
+    std::string base_path_;
+    size_t segment_size_;
+    unsigned next_seq_;
+    int fd_;
+    std::string segment_path_;
+    uint64_t file_size_;
+    std::string buffer_;
+    binlog::IndexHeader index_header_;
+    std::vector<binlog::IndexEntry> index_;
+};
+
+#endif
@@ -0,0 +1,72 @@
+/**
+ * @file FlightRecorderFormat.h
+ * @author KevinGlaser
+ * @brief Layout of the flight recorder shared memory ring, shared by the Server and the Guardian
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef __FLIGHTRECORDERFORMAT_H__
+#define __FLIGHTRECORDERFORMAT_H__
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <sys/types.h>
+
+/**
+ * The segment /cpp_server_flight_<pid> is a Header followed by capacity bytes of ring data. The
+ * Server appends formatted log lines and only then publishes the new write_pos with a release
+ * store, so a reader that loads write_pos with acquire sees complete lines up to that position even
+ * if the writer died in the middle of a copy. Byte i of the stream lives at data[i % capacity].
+ *
+ * The segment outlives the process. The Guardian reads it after the child exited and unlinks it.
+ */
+namespace flight {
+
+constexpr char MAGIC[8] = {'C', 'M', 'S', 'F', 'L', 'T', 'R', '1'};
+constexpr uint32_t FORMAT_VERSION = 1;
+constexpr size_t DEFAULT_CAPACITY = 1024 * 1024;
+
+enum State : uint32_t {
+    STATE_RUNNING = 1,
+    STATE_CLOSED = 2            // the handler was destroyed normally, nothing to investigate
+};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t capacity;          // bytes of ring data, a power of two
+    int64_t pid;
+    std::atomic<uint32_t> state;
+    uint32_t reserved;
+    std::atomic<uint64_t> write_pos;    // total bytes ever written
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "flight recorder needs lock free 64 bit atomics");
+
+inline std::string SegmentName(pid_t pid) {
+    return "/cpp_server_flight_" + std::to_string(pid);
+}
+
+inline char* Data(Header* header) {
+    return reinterpret_cast<char*>(header) + header->header_size;
+}
+
+inline bool Valid(const Header* header, size_t mapped_size) {
+    return memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0
+        && header->version == FORMAT_VERSION
+        && header->header_size >= sizeof(Header)
+        && header->capacity > 0 && (header->capacity & (header->capacity - 1)) == 0
+        && header->header_size + header->capacity <= mapped_size;
+}
+
+} // namespace flight
+
+#endif
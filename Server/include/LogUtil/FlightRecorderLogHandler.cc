@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "FlightRecorderLogHandler.h"
+
+FlightRecorderLogHandler::FlightRecorderLogHandler(size_t capacity)
+    : header_(nullptr)
+    , data_(nullptr)
+    , mapped_size_(0)
+    , capacity_(1)
+    , write_pos_(0) {
+    while (capacity_ < capacity) {
+        capacity_ <<= 1;
+    }
+
+    std::string name = flight::SegmentName(getpid());
+    int fd = shm_open(name.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0600);
+    if (fd == -1) {
+        std::cerr << "Failed to create flight recorder " << name << ": " << strerror(errno) << std::endl;
+        return;
+    }
+
+    // 预分配内存页,崩溃时已写入的数据仍留在共享内存中
+    mapped_size_ = sizeof(flight::Header) + capacity_;
+    if (ftruncate(fd, static_cast<off_t>(mapped_size_)) != 0) {
+        std::cerr << "Failed to size flight recorder " << name << ": " << strerror(errno) << std::endl;
+        close(fd);
+        shm_unlink(name.c_str());
+        return;
+    }
+    void* addr = mmap(nullptr, mapped_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        std::cerr << "Failed to map flight recorder " << name << ": " << strerror(errno) << std::endl;
+        shm_unlink(name.c_str());
+        return;
+    }
+
+    header_ = new (addr) flight::Header();
+    header_->version = flight::FORMAT_VERSION;
+    header_->header_size = sizeof(flight::Header);
+    header_->capacity = capacity_;
+    header_->pid = getpid();
+    header_->state.store(flight::STATE_RUNNING, std::memory_order_relaxed);
+    header_->write_pos.store(0, std::memory_order_relaxed);
+    data_ = flight::Data(header_);
+    // magic最后写入,读端看到magic时其余字段已经有效
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(header_->magic, flight::MAGIC, sizeof(flight::MAGIC));
+
+    std::cout << "FlightRecorderLogHandler" << std::endl << std::flush;
+}
+
+FlightRecorderLogHandler::~FlightRecorderLogHandler() {
+    if (header_ != nullptr) {
+        header_->state.store(flight::STATE_CLOSED, std::memory_order_release);
+        munmap(header_, mapped_size_);
+    }
+    std::cout << "~FlightRecorderLogHandler" << std::endl << std::flush;
+}
+
+void FlightRecorderLogHandler::copy(const char* data, size_t len) {
+    // 超过环大小的部分只保留最后capacity字节
+    if (len > capacity_) {
+        write_pos_ += len - capacity_;
+        data += len - capacity_;
+        len = capacity_;
+    }
+    size_t offset = static_cast<size_t>(write_pos_ & (capacity_ - 1));
+    size_t first = std::min<size_t>(len, capacity_ - offset);
+    memcpy(data_ + offset, data, first);
+    memcpy(data_, data + first, len - first);
+    write_pos_ += len;
+}
+
+void FlightRecorderLogHandler::append(const std::string& message) {
+    copy(message.data(), message.size());
+    copy("\n", 1);
+    // 每行写完立即发布位置:读端只看到完整的行,崩溃时最多破坏环中最旧的一行
+    header_->write_pos.store(write_pos_, std::memory_order_release);
+}
+
+void FlightRecorderLogHandler::HandleLog(const std::string& message, LogLevel) {
+    if (header_ == nullptr) {
+        return;
+    }
+    append(message);
+}
+
+void FlightRecorderLogHandler::HandleBatch(const std::vector<LogRecord>& batch) {
+    if (header_ == nullptr) {
+        return;
+    }
+    for (const auto& record : batch) {
+        append(record.message);
+    }
+}
@@ -0,0 +1,46 @@
+/**
+ * @file FlightRecorderLogHandler.h
+ * @author KevinGlaser
+ * @brief Log handler keeping the most recent log lines in a shared memory ring for post-mortem dumps
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef __FLIGHTRECORDERLOGHANDLER_H__
+#define __FLIGHTRECORDERLOGHANDLER_H__
+
+#include "LogUtil.h"
+#include "FlightRecorderFormat.h"
+
+/**
+ * @brief Copies every formatted line into the shared memory segment flight::SegmentName(getpid()).
+ *        Writing is a memcpy plus one atomic store per line, no syscall. The segment is not
+ *        unlinked here: when the process dies the Guardian dumps the tail of the ring to disk and
+ *        removes it. A normal destruction marks the segment STATE_CLOSED.
+ */
+class FlightRecorderLogHandler : public LogHandler {
+public:
+    /**
+     * @param capacity ring size in bytes, rounded up to a power of two
+     */
+    explicit FlightRecorderLogHandler(size_t capacity = flight::DEFAULT_CAPACITY);
+    virtual ~FlightRecorderLogHandler() override;
+
+    void HandleLog(const std::string& message, LogLevel level) override;
+    void HandleBatch(const std::vector<LogRecord>& batch) override;
+
+private:
+    void copy(const char* data, size_t len);
+    void append(const std::string& message);
+
+    flight::Header* header_;
+    char* data_;
+    size_t mapped_size_;
+    uint64_t capacity_;
+    uint64_t write_pos_;
+};
+
+#endif
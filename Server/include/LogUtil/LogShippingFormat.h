@@ -0,0 +1,65 @@
+/**
+ * @file LogShippingFormat.h
+ * @author KevinGlaser
+ * @brief Datagram layout used by ShippingLogHandler to send log records to the Guardian's collector
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef __LOGSHIPPINGFORMAT_H__
+#define __LOGSHIPPINGFORMAT_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "BinaryLogFormat.h"
+
+/**
+ * Each datagram on the collector's AF_UNIX SOCK_DGRAM socket is a DatagramHeader followed by
+ * record_count records encoded with binlog::EncodeRecord. The socket lives in the abstract
+ * namespace, so there is no file to clean up and it disappears with the Guardian.
+ *
+ * seq counts the datagrams of one sender, a gap tells the collector that datagrams were lost in the
+ * socket buffer. lost_records counts records the sender itself could not ship since the previous
+ * datagram (socket buffer full).
+ */
+namespace logship {
+
+constexpr char SOCKET_NAME[] = "cpp_multiserver_log_collector";
+constexpr uint32_t MAGIC = 0x474c5343;      // "CSLG"
+constexpr uint16_t FORMAT_VERSION = 1;
+// 保证单个数据报能放进默认的socket发送缓冲区
+constexpr size_t MAX_DATAGRAM = 60 * 1024;
+
+struct DatagramHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t pid;
+    uint32_t record_count;
+    uint64_t seq;
+    uint64_t lost_records;
+};
+
+/**
+ * @brief fill addr with the collector's abstract socket address
+ * @return [socklen_t] length to pass to bind() / sendto()
+ */
+inline socklen_t CollectorAddress(sockaddr_un& addr) {
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    // 抽象命名空间:sun_path以'\0'开头,长度不含结尾的'\0'
+    memcpy(addr.sun_path + 1, SOCKET_NAME, sizeof(SOCKET_NAME) - 1);
+    return static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + 1 + sizeof(SOCKET_NAME) - 1);
+}
+
+} // namespace logship
+
+#endif
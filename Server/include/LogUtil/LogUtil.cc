@@ -3,14 +3,70 @@
 #include <ctime>
 #include <thread>
 #include <iomanip>
+#include <cerrno>
+#include <cstring>
+#include <climits>
+#include <cctype>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
 
 #include "LogUtil.h"
 
-void Logger::AddHandler(std::unique_ptr<LogHandler> handler) {
+#ifndef IOV_MAX
+    #define IOV_MAX 1024
+#endif
+
+// writev() every line in one call per IOV_MAX lines, retrying on short writes
+static bool writeLines(int fd, const std::vector<std::string>& lines) {
+    std::vector<struct iovec> iov;
+    iov.reserve(std::min<size_t>(lines.size(), IOV_MAX));
+
+    size_t next = 0;
+    while (next < lines.size()) {
+        iov.clear();
+        for (; next < lines.size() && iov.size() < IOV_MAX; ++next) {
+            iov.push_back({const_cast<char*>(lines[next].data()), lines[next].size()});
+        }
+
+        size_t first = 0;
+        while (first < iov.size()) {
+            ssize_t written = writev(fd, &iov[first], static_cast<int>(iov.size() - first));
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                std::cerr << "writev() failed: " << strerror(errno) << std::endl;
+                return false;
+            }
+
+            size_t left = static_cast<size_t>(written);
+            while (first < iov.size() && left >= iov[first].iov_len) {
+                left -= iov[first].iov_len;
+                ++first;
+            }
+            if (left > 0) {
+                iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + left;
+                iov[first].iov_len -= left;
+            }
+        }
+    }
+    return true;
+}
+
+void Logger::AddHandler(std::unique_ptr<LogHandler> handler, LogDispatch dispatch) {
+    if (dispatch == LogDispatch::DEDICATED) {
+        p_log->dispatcher.AddHandler(std::move(handler));
+        return;
+    }
+    std::lock_guard<std::mutex> lock(p_log->handlers_mtx);
     p_log->p_handlers.emplace_back(std::move(handler));
 }
 
 void Logger::RemoveHandler(std::unique_ptr<LogHandler>&& handler) {
+    std::lock_guard<std::mutex> lock(p_log->handlers_mtx);
     auto it = std::find(p_log->p_handlers.begin(), p_log->p_handlers.end(), handler);
     if(it != p_log->p_handlers.end()) {
         it = p_log->p_handlers.erase(it);
@@ -18,18 +74,156 @@ void Logger::RemoveHandler(std::unique_ptr<LogHandler>&& handler) {
 } 
 
 void Logger::WriteLog(const std::string& message, LogLevel level) {
-    std::time_t now = std::time(nullptr);
-    std::tm* now_tm = std::localtime(&now);
+    if (!ShouldLog(level)) {
+        return;
+    }
+
+    LogRecord record;
+    record.level = level;
+    record.source_id = 0;
+    record.body = message;
+    p_log->Enqueue(record);
+}
+
+void Logger::WriteStructured(LogLevel level, uint32_t source_id, const std::string& message,
+                             std::vector<LogField> fields) {
+    if (!ShouldLog(level)) {
+        return;
+    }
+
+    LogRecord record;
+    record.level = level;
+    record.source_id = source_id;
+    record.body = message;
+    record.fields = std::move(fields);
+    p_log->Enqueue(record);
+}
 
-    std::stringstream ss;
-    ss << std::put_time(now_tm, "%Y-%m-%d %H:%M:%S");
+void Logger::SetOverflowPolicy(OverflowPolicy policy, size_t sample_rate) {
+    p_log->sample_rate.store(std::max<size_t>(sample_rate, 1), std::memory_order_relaxed);
+    p_log->overflow_policy.store(policy, std::memory_order_relaxed);
+}
 
-    std::string time_str = ss.str();
-    std::string full_message = time_str + " [" + LogLevelToString(level) + "] " + "log_queue_size:" + std::to_string(p_log->log_queues.size()) + " message:" + message;
+void Logger::SetQueueCapacity(size_t records) {
+    size_t capacity = 16;
+    while (capacity < records) {
+        capacity <<= 1;
+    }
+    p_log->staging_capacity.store(capacity, std::memory_order_relaxed);
+}
 
-    std::lock_guard<std::mutex> lck(p_log->qeueue_mtx);
-    p_log->log_queues.emplace(full_message, level);
-    p_log->queue_cv.notify_one();
+uint64_t Logger::DroppedCount() const {
+    return p_log->dropped_total.load(std::memory_order_relaxed);
+}
+
+void Logger::LoggerImpl::Enqueue(LogRecord& record) {
+    LogStagingBuffer* local = LocalBuffer();
+    if (local == nullptr) {
+        EnqueueExited(record);
+        return;
+    }
+    LogStagingBuffer& buffer = *local;
+    record.queue_size = buffer.Size();
+
+    // 超过高水位才需要查看溢出策略,正常情况下只多一次比较
+    if (record.queue_size >= buffer.HighWater() && !Admit(buffer, record.level)) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    record.timestamp = std::chrono::system_clock::now();
+    record.thread_id = std::this_thread::get_id();
+
+    // 本线程的缓冲区写满时让出CPU等日志线程取走,不与其他线程竞争任何锁
+    while (!buffer.TryPush(record)) {
+        if (!MayBlock(record.level)) {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        WakeUp();
+        std::this_thread::yield();
+    }
+    WakeUp();
+}
+
+void Logger::LoggerImpl::EnqueueExited(LogRecord& record) {
+    record.timestamp = std::chrono::system_clock::now();
+    record.thread_id = std::this_thread::get_id();
+    {
+        std::lock_guard<std::mutex> lock(staging_mtx);
+        record.queue_size = exited_records.size();
+        exited_records.emplace_back(std::move(record));
+    }
+    WakeUp();
+}
+
+bool Logger::LoggerImpl::Admit(LogStagingBuffer& buffer, LogLevel level) {
+    switch (overflow_policy.load(std::memory_order_relaxed)) {
+        case OverflowPolicy::DROP_LOW_PRIORITY:
+            return level >= WARN;
+        case OverflowPolicy::SAMPLE:
+            return level == ERROR || buffer.sample_counter++ % sample_rate.load(std::memory_order_relaxed) == 0;
+        case OverflowPolicy::BLOCK:
+        default:
+            return true;
+    }
+}
+
+bool Logger::LoggerImpl::MayBlock(LogLevel level) const {
+    switch (overflow_policy.load(std::memory_order_relaxed)) {
+        case OverflowPolicy::DROP_LOW_PRIORITY:
+            return level >= WARN;
+        case OverflowPolicy::SAMPLE:
+            return level == ERROR;
+        case OverflowPolicy::BLOCK:
+        default:
+            return true;
+    }
+}
+
+void Logger::LoggerImpl::ReportDropped(std::vector<LogRecord>& batch, bool force) {
+    if (dropped_unreported == 0) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (!force && now - last_drop_report < DROP_REPORT_INTERVAL) {
+        return;
+    }
+
+    LogRecord record;
+    record.timestamp = std::chrono::system_clock::now();
+    record.thread_id = std::this_thread::get_id();
+    record.level = WARN;
+    record.source_id = 0;
+    record.queue_size = 0;
+    record.body = "dropped " + std::to_string(dropped_unreported) + " messages";
+    record.fields.emplace_back("dropped", dropped_unreported);
+    batch.emplace_back(std::move(record));
+
+    dropped_unreported = 0;
+    last_drop_report = now;
+}
+
+void Logger::LoggerImpl::ReportRepeats(std::vector<LogRecord>& batch, bool force) {
+    auto now = std::chrono::steady_clock::now();
+    if (!force && now - last_repeat_scan < DEDUP_QUIET) {
+        return;
+    }
+    last_repeat_scan = now;
+
+    std::vector<std::pair<LogLevel, std::string>> summaries;
+    LogDeduplicator::CollectQuiet(force ? std::chrono::steady_clock::duration::zero()
+                                        : std::chrono::steady_clock::duration(DEDUP_QUIET), summaries);
+    for (auto& summary : summaries) {
+        LogRecord record;
+        record.timestamp = std::chrono::system_clock::now();
+        record.thread_id = std::this_thread::get_id();
+        record.level = summary.first;
+        record.source_id = 0;
+        record.queue_size = 0;
+        record.body = std::move(summary.second);
+        batch.emplace_back(std::move(record));
+    }
 }
 
 Logger::~Logger()
@@ -37,40 +231,492 @@ Logger::~Logger()
     std::cout << "~Logger" << std::endl << std::flush;
 }
 
+LogStagingBuffer::LogStagingBuffer(size_t capacity)
+    : retired(false), dropped(0), sample_counter(0), slots_(capacity), mask_(capacity - 1)
+    , high_water_(capacity - capacity / 4), head_(0), cached_tail_(0), tail_(0) {}
+
+bool LogStagingBuffer::TryPush(LogRecord& record) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head - cached_tail_ == slots_.size()) {
+        cached_tail_ = tail_.load(std::memory_order_acquire);
+        if (head - cached_tail_ == slots_.size()) {
+            return false;
+        }
+    }
+    slots_[head & mask_] = std::move(record);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+size_t LogStagingBuffer::Drain(std::vector<LogRecord>& out) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t head = head_.load(std::memory_order_acquire);
+    for (size_t i = tail; i != head; ++i) {
+        out.emplace_back(std::move(slots_[i & mask_]));
+    }
+    tail_.store(head, std::memory_order_release);
+    return head - tail;
+}
+
+bool LogStagingBuffer::Empty() const {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+}
+
+size_t LogStagingBuffer::Size() const {
+    return head_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_relaxed);
+}
+
+namespace {
+// 平凡析构的thread_local,exit()之后静态对象的析构函数里仍可安全读取;缓冲区由staging_buffers持有
+thread_local LogStagingBuffer* local_buffer = nullptr;
+thread_local bool local_buffer_exited = false;
+
+// 线程退出时标记缓冲区作废,由日志线程取完剩余记录后注销;之后本线程的记录走EnqueueExited
+struct StagingExitHook {
+    ~StagingExitHook() {
+        if (local_buffer != nullptr) {
+            local_buffer->retired.store(true, std::memory_order_release);
+        }
+        local_buffer = nullptr;
+        local_buffer_exited = true;
+    }
+};
+}
+
+LogStagingBuffer* Logger::LoggerImpl::LocalBuffer() {
+    if (local_buffer == nullptr && !local_buffer_exited) {
+        thread_local StagingExitHook exit_hook;
+        (void)exit_hook;
+        auto buffer = std::make_shared<LogStagingBuffer>(staging_capacity.load(std::memory_order_relaxed));
+        std::lock_guard<std::mutex> lock(staging_mtx);
+        staging_buffers.push_back(buffer);
+        local_buffer = buffer.get();
+    }
+    return local_buffer;
+}
+
+void Logger::LoggerImpl::WakeUp() {
+    // 与WorkThread中的fence配对: 要么生产者看到sleeping,要么日志线程休眠前看到新记录
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed) && sleeping.exchange(false)) {
+        std::lock_guard<std::mutex> lck(qeueue_mtx);
+        queue_cv.notify_one();
+    }
+}
+
+void Logger::LoggerImpl::CollectStaged(std::vector<LogRecord>& batch) {
+    size_t sources = 0;
+    std::lock_guard<std::mutex> lock(staging_mtx);
+    for (auto it = staging_buffers.begin(); it != staging_buffers.end();) {
+        // 先读retired再取数据,保证注销前线程最后写入的记录已经取走
+        bool retired = (*it)->retired.load(std::memory_order_acquire);
+        if ((*it)->Drain(batch) > 0) {
+            ++sources;
+        }
+        uint64_t dropped = (*it)->dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0) {
+            dropped_unreported += dropped;
+            dropped_total.fetch_add(dropped, std::memory_order_relaxed);
+        }
+        if (retired) {
+            it = staging_buffers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (!exited_records.empty()) {
+        ++sources;
+        for (auto& record : exited_records) {
+            batch.emplace_back(std::move(record));
+        }
+        exited_records.clear();
+    }
+
+    // 独立线程的handler落后太多而跳过的记录也计入丢弃数
+    uint64_t skipped = dispatcher.TakeSkipped();
+    if (skipped > 0) {
+        dropped_unreported += skipped;
+        dropped_total.fetch_add(skipped, std::memory_order_relaxed);
+    }
+
+    // 每个缓冲区内部已按时间有序,多个来源时合并成全局时间序
+    if (sources > 1) {
+        std::stable_sort(batch.begin(), batch.end(), [](const LogRecord& a, const LogRecord& b) {
+            return a.timestamp < b.timestamp;
+        });
+    }
+}
+
+bool Logger::LoggerImpl::HasStaged() {
+    std::lock_guard<std::mutex> lock(staging_mtx);
+    if (!exited_records.empty()) {
+        return true;
+    }
+    for (const auto& buffer : staging_buffers) {
+        if (!buffer->Empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Logger::LoggerImpl::FormatRecord(LogRecord& record) {
+    std::time_t now = std::chrono::system_clock::to_time_t(record.timestamp);
+    if (now != formatted_second || formatted_time.empty()) {
+        std::tm now_tm;
+        localtime_r(&now, &now_tm);
+        std::stringstream ss;
+        ss << std::put_time(&now_tm, "%Y-%m-%d %H:%M:%S");
+        formatted_time = ss.str();
+        formatted_second = now;
+    }
+
+    record.message.clear();
+    record.message.append(formatted_time).append(" [").append(LogLevelToString(record.level)).append("] ")
+        .append("log_queue_size:").append(std::to_string(record.queue_size))
+        .append(" message:").append(record.body);
+
+    for (const auto& field : record.fields) {
+        record.message.append(" ").append(field.name).append("=");
+        std::visit([&record](const auto& v) {
+            using T = std::decay_t<decltype(v)>;
+            if constexpr (std::is_same_v<T, std::string>) {
+                record.message.append(v);
+            } else if constexpr (std::is_same_v<T, bool>) {
+                record.message.append(v ? "true" : "false");
+            } else {
+                record.message.append(std::to_string(v));
+            }
+        }, field.value);
+    }
+}
+
 Logger::LoggerImpl::~LoggerImpl()
 {
     std::cout << "~LoggerImpl" << std::endl << std::flush;
     
+    should_stop.store(true);
     {
         std::lock_guard<std::mutex> lock(qeueue_mtx);
-        log_queues.emplace("", LogLevel::ERROR);  // 放一个空消息作为停止信号
-        should_stop = true;
+        sleeping.store(false);
     }
     queue_cv.notify_one();
 
-    // 等待线程完成
+    // 等待线程把缓冲区中剩余的日志写完,再让独立线程的handler处理完已发布的批次
     if (work_thread_ptr && work_thread_ptr->joinable()) {
         work_thread_ptr->join();
     }
+    dispatcher.Close();
 }
 
 void Logger::LoggerImpl::WorkThread() {
+    std::vector<LogRecord> batch;
     while(true) {
-        std::string message;
-        LogLevel level;
-        {
-            std::unique_lock<std::mutex> lck(qeueue_mtx);
-            queue_cv.wait(lck, [this]{return !log_queues.empty() || should_stop; });
-            if(should_stop == true) {
+        bool stopping = should_stop.load();
+        CollectStaged(batch);
+        ReportDropped(batch, stopping);
+        ReportRepeats(batch, stopping);
+
+        if (batch.empty()) {
+            if (stopping) {
                 break;
             }
-            std::tie(message, level) = log_queues.front();
-            log_queues.pop();
+
+            // 先声明要休眠再复查一遍,避免错过休眠前刚写入的记录
+            sleeping.store(true);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bool timed_out = false;
+            if (!HasStaged()) {
+                std::unique_lock<std::mutex> lck(qeueue_mtx);
+                timed_out = !queue_cv.wait_for(lck, IDLE_TICK, [this]{
+                    return !sleeping.load() || should_stop.load();
+                });
+            }
+            sleeping.store(false);
+
+            if (timed_out) {
+                std::lock_guard<std::mutex> lock(handlers_mtx);
+                for(auto& handler : p_handlers) {
+                    handler->OnIdle();
+                }
+            }
+            continue;
         }
 
+        std::lock_guard<std::mutex> lock(handlers_mtx);
+        bool needs_text = dispatcher.NeedsFormattedText() || std::any_of(p_handlers.begin(), p_handlers.end(),
+            [](const std::unique_ptr<LogHandler>& handler) { return handler->NeedsFormattedText(); });
+        if (needs_text) {
+            for (auto& record : batch) {
+                FormatRecord(record);
+            }
+        }
+
+        if (dispatcher.Empty()) {
+            for(auto& handler : p_handlers) {
+                handler->HandleBatch(batch);
+            }
+            batch.clear();
+            continue;
+        }
+
+        // 先发布给独立线程的handler,再在本线程处理内联handler,两者并行
+        auto shared = std::make_shared<const std::vector<LogRecord>>(std::move(batch));
+        dispatcher.Publish(shared);
         for(auto& handler : p_handlers) {
-            handler->HandleLog(message, level);
+            handler->HandleBatch(*shared);
         }
+        batch = std::vector<LogRecord>();
+    }
+
+    std::lock_guard<std::mutex> lock(handlers_mtx);
+    for(auto& handler : p_handlers) {
+        handler->Flush();
+    }
+}
+
+static int64_t steadyNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+LogRateLimiter::LogRateLimiter(uint32_t max_per_interval, std::chrono::steady_clock::duration interval)
+    : max_per_interval_(max_per_interval)
+    , interval_ns_(std::chrono::duration_cast<std::chrono::nanoseconds>(interval).count())
+    , window_start_(steadyNanoseconds())
+    , count_(0)
+    , suppressed_(0) {}
+
+bool LogRateLimiter::Allow(uint64_t& suppressed) {
+    int64_t now = steadyNanoseconds();
+    int64_t start = window_start_.load(std::memory_order_relaxed);
+    // 只有抢到新窗口的线程负责清零计数并带出上个窗口被压下的条数
+    if (now - start >= interval_ns_ && window_start_.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+        count_.store(0, std::memory_order_relaxed);
+        suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+    }
+    if (count_.fetch_add(1, std::memory_order_relaxed) < max_per_interval_) {
+        return true;
+    }
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+namespace {
+
+// 所有LOG_DEDUP调用点;故意不析构,静态对象析构期间日志线程仍可能访问
+struct DedupRegistry {
+    std::mutex mtx;
+    std::vector<LogDeduplicator*> live;
+    std::vector<std::pair<LogLevel, std::string>> orphaned;     // 已析构调用点留下的计数
+};
+
+DedupRegistry& dedupRegistry() {
+    static DedupRegistry* registry = new DedupRegistry();
+    return *registry;
+}
+
+} // namespace
+
+LogDeduplicator::LogDeduplicator(LogLevel level, std::chrono::steady_clock::duration max_hold)
+    : level_(level), max_hold_(max_hold), repeats_(0) {
+    DedupRegistry& registry = dedupRegistry();
+    std::lock_guard<std::mutex> lock(registry.mtx);
+    registry.live.push_back(this);
+}
+
+LogDeduplicator::~LogDeduplicator() {
+    DedupRegistry& registry = dedupRegistry();
+    std::lock_guard<std::mutex> lock(registry.mtx);
+    registry.live.erase(std::remove(registry.live.begin(), registry.live.end(), this), registry.live.end());
+    // 静态对象先于Logger析构,计数交给日志线程在停止时写出
+    std::string summary = takeSummary();
+    if (!summary.empty()) {
+        registry.orphaned.emplace_back(level_, std::move(summary));
+    }
+}
+
+std::string LogDeduplicator::takeSummary() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (repeats_ == 0) {
+        return std::string();
+    }
+    std::string summary = "last message repeated " + std::to_string(repeats_) + " times: " + last_;
+    repeats_ = 0;
+    held_since_ = std::chrono::steady_clock::now();
+    return summary;
+}
+
+bool LogDeduplicator::Submit(const std::string& message, std::string& summary) {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (message == last_) {
+        ++repeats_;
+        last_seen_ = now;
+        // 持续重复时也定期输出一次计数
+        if (now - held_since_ >= max_hold_) {
+            summary = "last message repeated " + std::to_string(repeats_) + " times: " + last_;
+            repeats_ = 0;
+            held_since_ = now;
+        }
+        return false;
+    }
+
+    if (repeats_ > 0) {
+        summary = "last message repeated " + std::to_string(repeats_) + " times: " + last_;
+    }
+    last_ = message;
+    repeats_ = 0;
+    held_since_ = now;
+    last_seen_ = now;
+    return true;
+}
+
+void LogDeduplicator::CollectQuiet(std::chrono::steady_clock::duration quiet,
+                                   std::vector<std::pair<LogLevel, std::string>>& summaries) {
+    auto now = std::chrono::steady_clock::now();
+    DedupRegistry& registry = dedupRegistry();
+    std::lock_guard<std::mutex> lock(registry.mtx);
+    for (auto& orphan : registry.orphaned) {
+        summaries.push_back(std::move(orphan));
+    }
+    registry.orphaned.clear();
+
+    for (LogDeduplicator* dedup : registry.live) {
+        {
+            std::lock_guard<std::mutex> dedup_lock(dedup->mtx_);
+            // 重复仍在继续的调用点由Submit按max_hold输出
+            if (dedup->repeats_ == 0 || now - dedup->last_seen_ < quiet) {
+                continue;
+            }
+        }
+        std::string summary = dedup->takeSummary();
+        if (!summary.empty()) {
+            summaries.emplace_back(dedup->level_, std::move(summary));
+        }
+    }
+}
+
+LogDispatcher::LogDispatcher(size_t capacity)
+    : slots_(capacity), head_(0), released_(0), records_published_(0), closed_(false), skipped_(0) {}
+
+LogDispatcher::~LogDispatcher() {
+    Close();
+}
+
+void LogDispatcher::AddHandler(std::unique_ptr<LogHandler> handler) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (closed_) {
+        return;
+    }
+    // 新handler从下一个发布的批次开始读
+    auto worker = std::make_unique<Worker>();
+    worker->handler = std::move(handler);
+    worker->cursor = head_;
+    worker->thread = std::thread(&LogDispatcher::Run, this, std::ref(*worker), records_published_);
+    workers_.emplace_back(std::move(worker));
+}
+
+bool LogDispatcher::Empty() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return workers_.empty();
+}
+
+bool LogDispatcher::NeedsFormattedText() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return std::any_of(workers_.begin(), workers_.end(),
+        [](const std::unique_ptr<Worker>& worker) { return worker->handler->NeedsFormattedText(); });
+}
+
+void LogDispatcher::Publish(Batch batch) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        Slot& slot = slots_[head_ % slots_.size()];
+        slot.first_record = records_published_;
+        records_published_ += batch->size();
+        slot.batch = std::move(batch);
+        ++head_;
+
+        // 所有handler都读过的批次立即释放,内存只被落后的handler占用
+        uint64_t min_cursor = head_;
+        for (const auto& worker : workers_) {
+            min_cursor = std::min(min_cursor, worker->cursor);
+        }
+        released_ = std::max(released_, head_ - std::min<uint64_t>(head_, slots_.size()));
+        for (; released_ < min_cursor; ++released_) {
+            slots_[released_ % slots_.size()].batch.reset();
+        }
+    }
+    cv_.notify_all();
+}
+
+void LogDispatcher::Close() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (closed_) {
+            return;
+        }
+        closed_ = true;
+    }
+    cv_.notify_all();
+
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+uint64_t LogDispatcher::TakeSkipped() {
+    return skipped_.exchange(0, std::memory_order_relaxed);
+}
+
+void LogDispatcher::Run(Worker& worker, uint64_t next_record) {
+    while (true) {
+        Batch batch;
+        uint64_t first_record = 0;
+        bool timed_out = false;
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            timed_out = !cv_.wait_for(lock, IDLE_TICK, [this, &worker] {
+                return head_ != worker.cursor || closed_;
+            });
+            if (head_ == worker.cursor) {
+                if (closed_) {
+                    break;
+                }
+            } else {
+                // 落后超过环的容量时,被覆盖的批次直接跳过
+                if (head_ - worker.cursor > slots_.size()) {
+                    worker.cursor = head_ - slots_.size();
+                }
+                const Slot& slot = slots_[worker.cursor % slots_.size()];
+                batch = slot.batch;
+                first_record = slot.first_record;
+                ++worker.cursor;
+            }
+        }
+
+        if (!batch) {
+            if (timed_out) {
+                worker.handler->OnIdle();
+            }
+            continue;
+        }
+
+        if (first_record > next_record) {
+            skipped_.fetch_add(first_record - next_record, std::memory_order_relaxed);
+        }
+        next_record = first_record + batch->size();
+        worker.handler->HandleBatch(*batch);
+    }
+    worker.handler->Flush();
+}
+
+void LogHandler::HandleBatch(const std::vector<LogRecord>& batch) {
+    for (const auto& record : batch) {
+        HandleLog(record.message, record.level);
     }
 }
 
@@ -78,20 +724,133 @@ void TerminalLogHandler::HandleLog(const std::string& message, LogLevel level) {
     std::cout << std::this_thread::get_id() << " " << message << std::endl << std::flush;
 }
 
+void TerminalLogHandler::HandleBatch(const std::vector<LogRecord>& batch) {
+    std::thread::id id = std::this_thread::get_id();
+    for (const auto& record : batch) {
+        std::cout << id << " " << record.message << '\n';
+    }
+    std::cout << std::flush;
+}
+
+FileLogHandler::FileLogHandler(const std::string& filename, const FlushPolicy& policy)
+    : fd_(-1), file_size_(0), policy_(policy), flush_requested_(false) {
+    reopen(filename);
+    if (policy_.max_pending_records > 0) {
+        pending_.reserve(policy_.max_pending_records);
+    }
+    std::cout << "FileLogHandler" << std::endl << std::flush;
+}
+
+FileLogHandler::~FileLogHandler() {
+    Flush();
+    if (fd_ != -1) {
+        close(fd_);
+    }
+    std::cout << "~FileLogHandler" << std::endl << std::flush;
+}
+
+bool FileLogHandler::reopen(const std::string& filename) {
+    if (fd_ != -1) {
+        close(fd_);
+    }
+    file_size_ = 0;
+    fd_ = open(filename.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ == -1) {
+        std::cerr << "Failed to open log file " << filename << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd_, &st) == 0) {
+        file_size_ = static_cast<size_t>(st.st_size);
+    }
+    return true;
+}
+
+void FileLogHandler::append(const std::string& message, LogLevel level) {
+    if (line_prefix_.empty()) {
+        // 只有日志线程会调用到这里,线程id在整个生命周期内不变
+        std::ostringstream oss;
+        oss << std::this_thread::get_id() << " ";
+        line_prefix_ = oss.str();
+    }
+    if (pending_.empty()) {
+        oldest_pending_ = std::chrono::steady_clock::now();
+    }
+
+    std::string line;
+    line.reserve(line_prefix_.size() + message.size() + 1);
+    line.append(line_prefix_).append(message).push_back('\n');
+    pending_.emplace_back(std::move(line));
+
+    if (level == ERROR && policy_.flush_on_error) {
+        flush_requested_ = true;
+    }
+}
+
+void FileLogHandler::flushIfDue() {
+    if (pending_.empty()) {
+        return;
+    }
+    if (flush_requested_
+        || (policy_.max_pending_records > 0 && pending_.size() >= policy_.max_pending_records)
+        || (policy_.max_delay.count() > 0
+            && std::chrono::steady_clock::now() - oldest_pending_ >= policy_.max_delay)) {
+        Flush();
+    }
+}
+
 void FileLogHandler::HandleLog(const std::string& message, LogLevel level) {
-    if (!file_.is_open()) {
-        std::cerr << "File not open" << std::endl;
+    append(message, level);
+    flushIfDue();
+}
+
+void FileLogHandler::HandleBatch(const std::vector<LogRecord>& batch) {
+    for (const auto& record : batch) {
+        append(record.message, record.level);
+    }
+    flushIfDue();
+}
+
+void FileLogHandler::OnIdle() {
+    flushIfDue();
+}
+
+void FileLogHandler::Flush() {
+    flush_requested_ = false;
+    if (pending_.empty()) {
         return;
     }
-    file_ << std::this_thread::get_id() << " " << message << std::endl << std::flush;
+    if (fd_ == -1) {
+        std::cerr << "File not open" << std::endl;
+    } else if (writeLines(fd_, pending_)) {
+        for (const auto& line : pending_) {
+            file_size_ += line.size();
+        }
+    }
+    pending_.clear();
 }
 
 std::string LogLevelToString(LogLevel level) {
     switch (level) {
+        case DEBUG: return "DEBUG";
+        case INFO: return "INFO";
         case WARN: return "WARN";
         case ERROR: return "ERROR";
-        case INFO: return "INFO";
-        case DEBUG: return "DEBUG";
     }
     return "UNKNOWN";
-}
\ No newline at end of file
+}
+
+bool LogLevelFromString(const std::string& name, LogLevel& level) {
+    std::string upper(name);
+    for (auto& c : upper) {
+        c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    for (int value = DEBUG; value <= ERROR; ++value) {
+        if (LogLevelToString(static_cast<LogLevel>(value)) == upper) {
+            level = static_cast<LogLevel>(value);
+            return true;
+        }
+    }
+    return false;
+}
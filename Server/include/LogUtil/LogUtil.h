@@ -15,19 +15,53 @@
 #include <memory>
 #include <iostream>
 #include <vector>
-#include <fstream>
+#include <string>
+#include <sstream>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <variant>
+#include <type_traits>
 #include <condition_variable>
 #include <mutex>
-#include <queue>
 #include <thread>
 
 #include "SingletonBase/Singleton.h"
 
+// 数值越大级别越高,预处理器也需要用到这些值来裁剪日志宏
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_ERROR 3
+
+// levels below this floor are compiled out of the LOG_* macros entirely
+#ifndef LOG_COMPILE_LEVEL
+    #define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG
+#endif
+
 enum LogLevel{
-    WARN,
-    ERROR,
-    INFO,
-    DEBUG
+    DEBUG = LOG_LEVEL_DEBUG,
+    INFO = LOG_LEVEL_INFO,
+    WARN = LOG_LEVEL_WARN,
+    ERROR = LOG_LEVEL_ERROR
+};
+
+/**
+ * @brief What a producing thread does when its staging buffer is under pressure
+ */
+enum class OverflowPolicy {
+    BLOCK,                  // wait for the logger thread, nothing is lost
+    DROP_LOW_PRIORITY,      // above the high-water mark drop DEBUG/INFO, WARN/ERROR wait only when full
+    SAMPLE                  // above the high-water mark keep one in N records, ERROR is always kept
+};
+
+/**
+ * @brief Where a handler runs: on the logger thread, or on its own thread fed by the shared
+ *        dispatch ring so that a slow sink cannot hold back the others
+ */
+enum class LogDispatch {
+    INLINE,
+    DEDICATED
 };
 
 enum LogTarget{
@@ -36,10 +70,103 @@ enum LogTarget{
     TERMINAL_FILE
 };
 
+/**
+ * @brief Typed key/value attached to a structured record, kept binary until a handler formats it
+ */
+struct LogField {
+    // 顺序即二进制格式中的类型标签,只能在末尾追加
+    using Value = std::variant<int64_t, uint64_t, double, bool, std::string>;
+
+    template<typename T>
+    LogField(std::string field_name, T&& field_value)
+        : name(std::move(field_name)), value(ToValue(std::forward<T>(field_value))) {}
+
+    std::string name;
+    Value value;
+
+private:
+    template<typename T>
+    static Value ToValue(T&& v) {
+        using U = std::decay_t<T>;
+        if constexpr (std::is_same_v<U, bool>) {
+            return Value(std::in_place_type<bool>, v);
+        } else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+            return Value(std::in_place_type<int64_t>, static_cast<int64_t>(v));
+        } else if constexpr (std::is_integral_v<U>) {
+            return Value(std::in_place_type<uint64_t>, static_cast<uint64_t>(v));
+        } else if constexpr (std::is_floating_point_v<U>) {
+            return Value(std::in_place_type<double>, static_cast<double>(v));
+        } else {
+            return Value(std::in_place_type<std::string>, std::string(std::forward<T>(v)));
+        }
+    }
+};
+
+struct LogRecord {
+    std::chrono::system_clock::time_point timestamp;
+    std::thread::id thread_id;
+    LogLevel level;
+    uint32_t source_id;     // call site, see LogSourceId(); 0 for plain WriteLog
+    size_t queue_size;      // depth of the producer's staging buffer when the record was queued
+    std::string body;       // text passed to WriteLog
+    std::vector<LogField> fields;
+    std::string message;    // formatted line, filled in by the logger thread before dispatch
+};
+
+/**
+ * @brief compile time id of a call site, FNV-1a over file name and line
+ */
+constexpr uint32_t LogSourceId(const char* file, unsigned line) {
+    uint32_t hash = 2166136261u;
+    for (; *file != '\0'; ++file) {
+        hash = (hash ^ static_cast<uint8_t>(*file)) * 16777619u;
+    }
+    for (int i = 0; i < 4; ++i) {
+        hash = (hash ^ ((line >> (i * 8)) & 0xffu)) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Decides when FileLogHandler pushes its buffered lines to disk,
+ *        whichever condition is met first triggers a single writev()
+ */
+struct FlushPolicy {
+    size_t max_pending_records = 512;                // flush after N buffered records, 0 disables
+    std::chrono::milliseconds max_delay{200};        // flush records buffered longer than T, 0 disables
+    bool flush_on_error = true;                      // flush at once when an ERROR record arrives
+};
+
 class LogHandler {
 public:
     LogHandler() { std::cout << "LogHandler" << std::endl << std::flush; }
     virtual void HandleLog(const std::string& message, LogLevel level) = 0;
+
+    /**
+     * @brief handle every record the logger thread drained in one pass,
+     *        the default implementation forwards them one by one to HandleLog
+     * 
+     * @param batch records in queue order
+     */
+    virtual void HandleBatch(const std::vector<LogRecord>& batch);
+
+    /**
+     * @brief called by the logger thread when the queue stayed empty for a tick,
+     *        handlers with time based flushing check their deadline here
+     */
+    virtual void OnIdle() {}
+
+    /**
+     * @brief push everything buffered so far to the sink, called on shutdown
+     */
+    virtual void Flush() {}
+
+    /**
+     * @brief whether HandleBatch reads LogRecord::message, the logger thread skips text
+     *        formatting entirely when no installed handler needs it
+     */
+    virtual bool NeedsFormattedText() const { return true; }
+
     virtual ~LogHandler() {
         std::cout << "~LogHandler" << std::endl << std::flush;
     }
@@ -49,54 +176,468 @@ class TerminalLogHandler : public LogHandler {
 public:
     TerminalLogHandler() { std::cout << "TerminalLogHandler" << std::endl << std::flush; }
     void HandleLog(const std::string& message, LogLevel level) override;
+    void HandleBatch(const std::vector<LogRecord>& batch) override;
     virtual ~TerminalLogHandler() override { std::cout << "~TerminalLogHandler" << std::endl << std::flush; }
 };
 
 class FileLogHandler : public LogHandler {
 public:
-    explicit FileLogHandler(const std::string& filename) : file_(filename, std::ios::out | std::ios::app)
-     {std::cout << "FileLogHandler" << std::endl << std::flush;}
-    virtual ~FileLogHandler() override { 
-        if(file_.is_open()) {
-            file_.close();
-        }
-        std::cout << "~FileLogHandler" << std::endl << std::flush; }
+    explicit FileLogHandler(const std::string& filename, const FlushPolicy& policy = FlushPolicy());
+    virtual ~FileLogHandler() override;
 
     void HandleLog(const std::string& message, LogLevel level) override;
-private:
-    std::ofstream file_;
+    void HandleBatch(const std::vector<LogRecord>& batch) override;
+    void OnIdle() override;
+    void Flush() override;
+
+protected:
+    /**
+     * @brief buffer one line, the caller decides when to flush
+     */
+    void append(const std::string& message, LogLevel level);
+
+    /**
+     * @brief flush if the record count or the age of the oldest pending line exceeds the policy
+     */
+    void flushIfDue();
+
+    /**
+     * @brief close the current file (if any) and append to filename from now on
+     * @return false if the new file could not be opened
+     */
+    bool reopen(const std::string& filename);
+
+    int fd_;
+    size_t file_size_;
+    FlushPolicy policy_;
+    std::vector<std::string> pending_;
+    std::chrono::steady_clock::time_point oldest_pending_;
+    bool flush_requested_;
+    std::string line_prefix_;
 };
 
 class Logger final : public Singleton<Logger>{
 public:
-    void AddHandler(std::unique_ptr<LogHandler> handler);
+    void AddHandler(std::unique_ptr<LogHandler> handler, LogDispatch dispatch = LogDispatch::INLINE);
     void RemoveHandler(std::unique_ptr<LogHandler>&& handler);
     void WriteLog(const std::string& message, LogLevel level);
+
+    /**
+     * @brief queue a record with typed fields, text handlers append them as name=value,
+     *        BinaryLogHandler stores them as they are
+     * 
+     * @param source_id call site id, usually LOG_SOURCE_ID
+     */
+    void WriteStructured(LogLevel level, uint32_t source_id, const std::string& message,
+                         std::vector<LogField> fields);
+
+    /**
+     * @brief set the runtime threshold, records below it are discarded before any formatting
+     */
+    void SetLevel(LogLevel level) { min_level.store(level, std::memory_order_relaxed); }
+    LogLevel GetLevel() const { return min_level.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief a single relaxed atomic load, check this before building a message
+     */
+    bool ShouldLog(LogLevel level) const { return level >= min_level.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief choose how producers behave when their staging buffer fills up
+     * 
+     * @param sample_rate N for OverflowPolicy::SAMPLE
+     */
+    void SetOverflowPolicy(OverflowPolicy policy, size_t sample_rate = 10);
+
+    /**
+     * @brief records each thread can stage, rounded up to a power of two; applies to threads
+     *        that log for the first time after the call. Memory used by the logger is bounded by
+     *        threads x capacity records.
+     */
+    void SetQueueCapacity(size_t records);
+
+    /**
+     * @brief records dropped by the overflow policy since startup
+     */
+    uint64_t DroppedCount() const;
 private:
-    Logger() : p_log(std::make_unique<LoggerImpl>()) { std::cout << "Logger" << std::endl << std::flush; }
+    Logger() : min_level(DEBUG), p_log(std::make_unique<LoggerImpl>()) { std::cout << "Logger" << std::endl << std::flush; }
     virtual ~Logger();
 
     friend class Singleton<Logger>;
     class LoggerImpl;
+    std::atomic<LogLevel> min_level;
     std::unique_ptr<LoggerImpl> p_log;
-    
+
 };
 
 std::string LogLevelToString(LogLevel level);
 
+/**
+ * @brief inverse of LogLevelToString, case-insensitive
+ *
+ * @return false if name is not a level, level is left unchanged
+ */
+bool LogLevelFromString(const std::string& name, LogLevel& level);
+
+/**
+ * @brief Single-producer single-consumer ring owned by one logging thread. Only the owner
+ *        pushes and only the logger thread drains, so the two sides share nothing but the
+ *        head/tail indices, each on its own cache line.
+ */
+class LogStagingBuffer {
+public:
+    explicit LogStagingBuffer(size_t capacity);
+
+    /**
+     * @brief producer side, moves the record in if there is room
+     * @return false if the ring is full
+     */
+    bool TryPush(LogRecord& record);
+
+    /**
+     * @brief consumer side, appends every published record to out
+     * @return number of records drained
+     */
+    size_t Drain(std::vector<LogRecord>& out);
+
+    bool Empty() const;
+    size_t Size() const;
+    size_t Capacity() const { return slots_.size(); }
+    size_t HighWater() const { return high_water_; }
+
+    // set by the owning thread on exit, the logger thread unregisters the buffer once it is drained
+    std::atomic<bool> retired;
+    // records the owner dropped under OverflowPolicy, collected by the logger thread
+    std::atomic<uint64_t> dropped;
+    // producer-only counter for OverflowPolicy::SAMPLE
+    uint64_t sample_counter;
+
+private:
+    std::vector<LogRecord> slots_;
+    const size_t mask_;
+    const size_t high_water_;
+    alignas(64) std::atomic<size_t> head_;      // next slot to write, advanced by the producer
+    size_t cached_tail_;                         // producer's last view of tail_
+    alignas(64) std::atomic<size_t> tail_;      // next slot to read, advanced by the consumer
+};
+
+/**
+ * @brief Per call site limiter behind LOG_RATE_LIMITED: at most max_per_interval records pass in
+ *        each interval, the rest are only counted. Lock free, the window boundaries are
+ *        approximate when several threads race at the edge of an interval.
+ */
+class LogRateLimiter {
+public:
+    LogRateLimiter(uint32_t max_per_interval, std::chrono::steady_clock::duration interval);
+
+    /**
+     * @brief whether this record may be written
+     * @param suppressed set to the number of records held back since the last window opened,
+     *        reported together with the first record of the new window
+     */
+    bool Allow(uint64_t& suppressed);
+
+private:
+    const uint32_t max_per_interval_;
+    const int64_t interval_ns_;
+    std::atomic<int64_t> window_start_;
+    std::atomic<uint32_t> count_;
+    std::atomic<uint64_t> suppressed_;
+};
+
+/**
+ * @brief Per call site filter behind LOG_DEDUP: a message identical to the previous one from the
+ *        same site is only counted. The count is written as a single "repeated N times" record when
+ *        a different message arrives, or on the next repeat once max_hold has passed, so a steady
+ *        stream of repeats still shows up periodically. When the repeats simply stop, the logger
+ *        thread collects the count once the site has been quiet for a while, and at shutdown.
+ */
+class LogDeduplicator {
+public:
+    explicit LogDeduplicator(LogLevel level, std::chrono::steady_clock::duration max_hold = std::chrono::seconds(30));
+    ~LogDeduplicator();
+
+    /**
+     * @brief whether message itself should be written
+     * @param summary set to the repeat record to write first, empty if there is none
+     */
+    bool Submit(const std::string& message, std::string& summary);
+
+    /**
+     * @brief take the repeat counts of every site that saw no repeat for quiet, and of sites
+     *        already destroyed; called by the logger thread
+     */
+    static void CollectQuiet(std::chrono::steady_clock::duration quiet,
+                             std::vector<std::pair<LogLevel, std::string>>& summaries);
+
+private:
+    std::string takeSummary();
+
+    const LogLevel level_;
+    const std::chrono::steady_clock::duration max_hold_;
+    std::mutex mtx_;
+    std::string last_;
+    uint64_t repeats_;
+    std::chrono::steady_clock::time_point held_since_;
+    std::chrono::steady_clock::time_point last_seen_;
+};
+
+/**
+ * Logging macros, the stream expression is only evaluated when the level passes both the
+ * compile time floor (LOG_COMPILE_LEVEL) and the runtime threshold (Logger::SetLevel):
+ *     LOG_DEBUG("queue " << id << " size:" << size);
+ * Levels below the floor still type-check their arguments but generate no code.
+ */
+#define LOG_WRITE(level, stream_expr)                                   \
+    do {                                                                \
+        Logger& log_instance_ = Logger::GetInstance();                  \
+        if (log_instance_.ShouldLog(level)) {                           \
+            std::ostringstream log_stream_;                             \
+            log_stream_ << stream_expr;                                 \
+            log_instance_.WriteLog(log_stream_.str(), level);           \
+        }                                                               \
+    } while (0)
+
+#define LOG_SOURCE_ID LogSourceId(__FILE__, __LINE__)
+
+/**
+ * Structured record with typed fields, e.g.
+ *     LOG_STRUCT(INFO, "connected", {"port", port}, {"retry", retries});
+ */
+#define LOG_STRUCT(level, message, ...)                                                   \
+    do {                                                                                  \
+        Logger& log_instance_ = Logger::GetInstance();                                    \
+        if ((level) >= LOG_COMPILE_LEVEL && log_instance_.ShouldLog(level)) {             \
+            log_instance_.WriteStructured(level, LOG_SOURCE_ID, message, {__VA_ARGS__});  \
+        }                                                                                 \
+    } while (0)
+
+/**
+ * Rate limited record for hot loops, e.g. at most 5 records per 10 seconds from this line:
+ *     LOG_RATE_LIMITED(ERROR, 5, std::chrono::seconds(10), "send failed: " << strerror(errno));
+ * Held back records cost one atomic increment, their stream expression is not evaluated. The
+ * number held back is appended to the next record that passes.
+ */
+#define LOG_RATE_LIMITED(level, max_per_interval, interval, stream_expr)                    \
+    do {                                                                                    \
+        Logger& log_instance_ = Logger::GetInstance();                                      \
+        if ((level) >= LOG_COMPILE_LEVEL && log_instance_.ShouldLog(level)) {               \
+            static LogRateLimiter log_limiter_(max_per_interval, interval);                 \
+            uint64_t log_suppressed_ = 0;                                                   \
+            if (log_limiter_.Allow(log_suppressed_)) {                                      \
+                std::ostringstream log_stream_;                                             \
+                log_stream_ << stream_expr;                                                 \
+                if (log_suppressed_ > 0) {                                                  \
+                    log_stream_ << " (suppressed " << log_suppressed_ << " similar messages)"; \
+                }                                                                           \
+                log_instance_.WriteLog(log_stream_.str(), level);                           \
+            }                                                                               \
+        }                                                                                   \
+    } while (0)
+
+/**
+ * Record collapsing identical consecutive messages from this line into one repeat count:
+ *     LOG_DEDUP(INFO, "Received message: " << buffer);
+ */
+#define LOG_DEDUP(level, stream_expr)                                                       \
+    do {                                                                                    \
+        Logger& log_instance_ = Logger::GetInstance();                                      \
+        if ((level) >= LOG_COMPILE_LEVEL && log_instance_.ShouldLog(level)) {               \
+            static LogDeduplicator log_dedup_(level);                                       \
+            std::ostringstream log_stream_;                                                 \
+            log_stream_ << stream_expr;                                                     \
+            std::string log_summary_;                                                       \
+            bool log_write_ = log_dedup_.Submit(log_stream_.str(), log_summary_);           \
+            if (!log_summary_.empty()) {                                                    \
+                log_instance_.WriteLog(log_summary_, level);                                \
+            }                                                                               \
+            if (log_write_) {                                                               \
+                log_instance_.WriteLog(log_stream_.str(), level);                           \
+            }                                                                               \
+        }                                                                                   \
+    } while (0)
+
+#define LOG_DISCARD(stream_expr)                                        \
+    do {                                                                \
+        if (false) {                                                    \
+            std::ostringstream log_stream_;                             \
+            log_stream_ << stream_expr;                                 \
+        }                                                               \
+    } while (0)
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_DEBUG
+    #define LOG_DEBUG(stream_expr) LOG_WRITE(DEBUG, stream_expr)
+#else
+    #define LOG_DEBUG(stream_expr) LOG_DISCARD(stream_expr)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_INFO
+    #define LOG_INFO(stream_expr) LOG_WRITE(INFO, stream_expr)
+#else
+    #define LOG_INFO(stream_expr) LOG_DISCARD(stream_expr)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_WARN
+    #define LOG_WARN(stream_expr) LOG_WRITE(WARN, stream_expr)
+#else
+    #define LOG_WARN(stream_expr) LOG_DISCARD(stream_expr)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_ERROR
+    #define LOG_ERROR(stream_expr) LOG_WRITE(ERROR, stream_expr)
+#else
+    #define LOG_ERROR(stream_expr) LOG_DISCARD(stream_expr)
+#endif
+
+/**
+ * @brief Ring of published batches shared by all DEDICATED handlers. The logger thread publishes
+ *        each formatted batch once; every handler thread follows with its own cursor. The logger
+ *        thread never waits for a handler: one that falls more than capacity batches behind skips
+ *        the overwritten batches and the skipped records are reported as dropped.
+ */
+class LogDispatcher {
+public:
+    using Batch = std::shared_ptr<const std::vector<LogRecord>>;
+
+    explicit LogDispatcher(size_t capacity);
+    ~LogDispatcher();
+
+    void AddHandler(std::unique_ptr<LogHandler> handler);
+    bool Empty() const;
+    bool NeedsFormattedText() const;
+    void Publish(Batch batch);
+
+    /**
+     * @brief let every handler thread finish the published batches, flush and exit
+     */
+    void Close();
+
+    /**
+     * @brief records skipped by lagging handlers since the last call
+     */
+    uint64_t TakeSkipped();
+
+private:
+    struct Slot {
+        Batch batch;
+        uint64_t first_record;      // sequence number of the batch's first record
+    };
+
+    struct Worker {
+        std::unique_ptr<LogHandler> handler;
+        uint64_t cursor;            // next batch to read, guarded by mtx_
+        std::thread thread;
+    };
+
+    void Run(Worker& worker, uint64_t next_record);
+
+    static constexpr std::chrono::milliseconds IDLE_TICK{50};
+
+    std::vector<Slot> slots_;
+    uint64_t head_;                 // batches published so far
+    uint64_t released_;             // slots before this one have been consumed by every worker
+    uint64_t records_published_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;
+    bool closed_;
+    std::atomic<uint64_t> skipped_;
+};
+
 class Logger::LoggerImpl {
 public:
-    LoggerImpl() : work_thread_ptr(std::make_shared<std::thread>(&LoggerImpl::WorkThread, this)), should_stop(false) { std::cout << "LoggerImpl" << std::endl << std::flush; }
+    LoggerImpl() : sleeping(false), should_stop(false), overflow_policy(OverflowPolicy::BLOCK), sample_rate(10),
+        staging_capacity(STAGING_CAPACITY), dropped_total(0), dropped_unreported(0), formatted_second(0),
+        dispatcher(DISPATCH_CAPACITY), work_thread_ptr(std::make_shared<std::thread>(&LoggerImpl::WorkThread, this)) { std::cout << "LoggerImpl" << std::endl << std::flush; }
     virtual ~LoggerImpl();
 
     void WorkThread();
 
+    /**
+     * @brief staging buffer of the calling thread, created and registered on first use
+     *
+     * @return nullptr once the thread's thread_local objects are destroyed, e.g. in static destructors
+     *         after exit(); such records go through EnqueueExited()
+     */
+    LogStagingBuffer* LocalBuffer();
+
+    /**
+     * @brief wake the logger thread if it announced that it is going to sleep
+     */
+    void WakeUp();
+
+    /**
+     * @brief move everything staged by all threads into batch, ordered by timestamp
+     */
+    void CollectStaged(std::vector<LogRecord>& batch);
+    bool HasStaged();
+
+    void FormatRecord(LogRecord& record);
+
+    /**
+     * @brief stage a record from the calling thread, applying the overflow policy
+     */
+    void Enqueue(LogRecord& record);
+
+    /**
+     * @brief stage a record from a thread that has no staging buffer anymore, under staging_mtx
+     */
+    void EnqueueExited(LogRecord& record);
+
+    /**
+     * @brief whether a record above the high-water mark is kept
+     */
+    bool Admit(LogStagingBuffer& buffer, LogLevel level);
+
+    /**
+     * @brief whether a record may wait for room in a full buffer instead of being dropped
+     */
+    bool MayBlock(LogLevel level) const;
+
+    /**
+     * @brief append a "dropped N messages" record once per DROP_REPORT_INTERVAL
+     */
+    void ReportDropped(std::vector<LogRecord>& batch, bool force);
+
+    /**
+     * @brief append the repeat counts LOG_DEDUP sites are still holding after DEDUP_QUIET without
+     *        a repeat, all of them when force is set
+     */
+    void ReportRepeats(std::vector<LogRecord>& batch, bool force);
+
+    // how long the logger thread sleeps on an empty queue before giving handlers an OnIdle() tick
+    static constexpr std::chrono::milliseconds IDLE_TICK{50};
+    // records each producing thread can stage before it has to wait for the logger thread
+    static constexpr size_t STAGING_CAPACITY = 1024;
+    // how often the logger thread reports records dropped by the overflow policy
+    static constexpr std::chrono::seconds DROP_REPORT_INTERVAL{1};
+    // how long a LOG_DEDUP site must see no repeat before the logger thread writes its count
+    static constexpr std::chrono::seconds DEDUP_QUIET{1};
+    // batches a DEDICATED handler may fall behind before it starts skipping
+    static constexpr size_t DISPATCH_CAPACITY = 256;
+
     std::vector<std::unique_ptr<LogHandler>> p_handlers;
-    std::queue<std::pair<std::string, LogLevel>> log_queues;
+    std::mutex handlers_mtx;
+    std::vector<std::shared_ptr<LogStagingBuffer>> staging_buffers;
+    // 线程的缓冲区注销之后写入的记录,与staging_buffers同受staging_mtx保护
+    std::vector<LogRecord> exited_records;
+    std::mutex staging_mtx;
     std::mutex qeueue_mtx;
     std::condition_variable queue_cv;
+    std::atomic<bool> sleeping;
+    std::atomic<bool> should_stop;
+    std::atomic<OverflowPolicy> overflow_policy;
+    std::atomic<size_t> sample_rate;
+    std::atomic<size_t> staging_capacity;
+    std::atomic<uint64_t> dropped_total;
+    uint64_t dropped_unreported;
+    std::chrono::steady_clock::time_point last_drop_report;
+    std::chrono::steady_clock::time_point last_repeat_scan;
+    std::time_t formatted_second;
+    std::string formatted_time;
+    LogDispatcher dispatcher;
     std::shared_ptr<std::thread> work_thread_ptr;
-    bool should_stop;
 };
 
 
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "MmapLogHandler.h"
+
+MmapLogHandler::MmapLogHandler(const std::string& base_path, size_t segment_size)
+    : base_path_(base_path)
+    , segment_size_(segment_size)
+    , next_seq_(1)
+    , fd_(-1)
+    , map_(nullptr)
+    , offset_(0)
+    , synced_(0) {
+    // 映射按页管理,段大小向上取整到页大小
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    segment_size_ = (segment_size_ + page - 1) / page * page;
+    openSegment();
+    std::cout << "MmapLogHandler" << std::endl << std::flush;
+}
+
+MmapLogHandler::~MmapLogHandler() {
+    closeSegment();
+    std::cout << "~MmapLogHandler" << std::endl << std::flush;
+}
+
+bool MmapLogHandler::openSegment() {
+    std::string path;
+    // 不覆盖上次运行留下的段文件
+    for (;; ++next_seq_) {
+        path = base_path_ + "." + std::to_string(next_seq_) + ".log";
+        if (access(path.c_str(), F_OK) != 0) {
+            break;
+        }
+    }
+    ++next_seq_;
+
+    fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd_ == -1) {
+        std::cerr << "Failed to create log segment " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // 预分配磁盘块,避免写入映射时才分配而触发缺页阻塞或SIGBUS
+    if (fallocate(fd_, 0, 0, static_cast<off_t>(segment_size_)) != 0
+        && ftruncate(fd_, static_cast<off_t>(segment_size_)) != 0) {
+        std::cerr << "Failed to preallocate log segment " << path << ": " << strerror(errno) << std::endl;
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    void* addr = mmap(nullptr, segment_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (addr == MAP_FAILED) {
+        std::cerr << "Failed to map log segment " << path << ": " << strerror(errno) << std::endl;
+        close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    map_ = static_cast<char*>(addr);
+    madvise(map_, segment_size_, MADV_SEQUENTIAL);
+    offset_ = 0;
+    synced_ = 0;
+    return true;
+}
+
+void MmapLogHandler::closeSegment() {
+    if (map_ != nullptr) {
+        // MS_ASYNC只是安排回写,不等待磁盘;页面已在page cache中,进程退出后数据仍会落盘
+        msync(map_, segment_size_, MS_ASYNC);
+        munmap(map_, segment_size_);
+        map_ = nullptr;
+    }
+    if (fd_ != -1) {
+        // 去掉预分配但未使用的尾部
+        if (ftruncate(fd_, static_cast<off_t>(offset_)) != 0) {
+            std::cerr << "Failed to trim log segment: " << strerror(errno) << std::endl;
+        }
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+void MmapLogHandler::copy(const char* data, size_t len) {
+    while (len > 0) {
+        if (map_ == nullptr || offset_ == segment_size_) {
+            closeSegment();
+            if (!openSegment()) {
+                return;
+            }
+        }
+        size_t n = std::min(len, segment_size_ - offset_);
+        memcpy(map_ + offset_, data, n);
+        offset_ += n;
+        data += n;
+        len -= n;
+    }
+}
+
+void MmapLogHandler::append(const std::string& message) {
+    if (line_prefix_.empty()) {
+        std::ostringstream oss;
+        oss << std::this_thread::get_id() << " ";
+        line_prefix_ = oss.str();
+    }
+
+    // 一行放不下时整行挪到下一个段,只有超过段大小的行才会被拆开
+    size_t len = line_prefix_.size() + message.size() + 1;
+    if (map_ != nullptr && len <= segment_size_ && len > segment_size_ - offset_) {
+        closeSegment();
+        openSegment();
+    }
+    copy(line_prefix_.data(), line_prefix_.size());
+    copy(message.data(), message.size());
+    copy("\n", 1);
+}
+
+void MmapLogHandler::HandleLog(const std::string& message, LogLevel) {
+    append(message);
+}
+
+void MmapLogHandler::HandleBatch(const std::vector<LogRecord>& batch) {
+    for (const auto& record : batch) {
+        append(record.message);
+    }
+}
+
+void MmapLogHandler::Flush() {
+    if (map_ == nullptr || offset_ == synced_) {
+        return;
+    }
+    // msync要求起始地址按页对齐
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t begin = synced_ / page * page;
+    msync(map_ + begin, offset_ - begin, MS_ASYNC);
+    synced_ = offset_;
+}
@@ -0,0 +1,374 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef LOG_WITH_ZLIB
+    #include <zlib.h>
+#endif
+
+#include "RotatingLogHandler.h"
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Background thread of RotatingFileLogHandler. Compresses rotated files and deletes the
+ *        oldest ones beyond the retention limits. Memory stays bounded: at most MAX_PENDING_JOBS
+ *        queued paths and a single CHUNK_SIZE buffer while compressing.
+ */
+class LogArchiver {
+public:
+    LogArchiver(const std::string& base_path, const RotationPolicy& policy);
+    ~LogArchiver();
+
+    /**
+     * @brief queue a rotated file, never blocks; if the queue is full the file is left
+     *        uncompressed and only the retention pass will see it
+     */
+    void Submit(const std::string& rotated_path);
+
+private:
+    void WorkThread();
+    bool compress(const std::string& path);
+    void enforceRetention();
+    bool isRotatedFile(const std::string& name) const;
+
+    static constexpr size_t MAX_PENDING_JOBS = 16;
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    fs::path dir_;
+    std::string prefix_;
+    RotationPolicy policy_;
+    std::deque<std::string> jobs_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    bool should_stop_;
+    std::thread worker_;
+};
+
+LogArchiver::LogArchiver(const std::string& base_path, const RotationPolicy& policy)
+    : policy_(policy), should_stop_(false) {
+    fs::path base(base_path);
+    dir_ = base.has_parent_path() ? base.parent_path() : fs::path(".");
+    prefix_ = base.filename().string() + "_";
+    worker_ = std::thread(&LogArchiver::WorkThread, this);
+}
+
+LogArchiver::~LogArchiver() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        should_stop_ = true;
+    }
+    cv_.notify_one();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+void LogArchiver::Submit(const std::string& rotated_path) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (jobs_.size() >= MAX_PENDING_JOBS) {
+            std::cerr << "Log archiver busy, leaving " << rotated_path << " uncompressed" << std::endl;
+            return;
+        }
+        jobs_.push_back(rotated_path);
+    }
+    cv_.notify_one();
+}
+
+void LogArchiver::WorkThread() {
+    // 启动时先按保留策略清理一次上次运行遗留的文件
+    enforceRetention();
+
+    while (true) {
+        std::string path;
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            cv_.wait(lock, [this] { return !jobs_.empty() || should_stop_; });
+            if (jobs_.empty()) {
+                break;
+            }
+            path = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+
+        if (policy_.compress) {
+            compress(path);
+        }
+        enforceRetention();
+    }
+}
+
+bool LogArchiver::compress(const std::string& path) {
+#ifdef LOG_WITH_ZLIB
+    std::string gz_path = path + ".gz";
+    std::string tmp_path = gz_path + ".tmp";
+
+    int in = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in == -1) {
+        std::cerr << "Failed to open " << path << " for compression: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    gzFile out = gzopen(tmp_path.c_str(), "wb6");
+    if (out == nullptr) {
+        std::cerr << "Failed to create " << tmp_path << std::endl;
+        close(in);
+        return false;
+    }
+    gzbuffer(out, CHUNK_SIZE);
+
+    std::vector<char> buffer(CHUNK_SIZE);
+    bool ok = true;
+    while (true) {
+        ssize_t n = read(in, buffer.data(), buffer.size());
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            ok = (n == 0);
+            break;
+        }
+        if (gzwrite(out, buffer.data(), static_cast<unsigned>(n)) != n) {
+            ok = false;
+            break;
+        }
+    }
+    close(in);
+    ok = (gzclose(out) == Z_OK) && ok;
+
+    if (!ok || std::rename(tmp_path.c_str(), gz_path.c_str()) != 0) {
+        std::cerr << "Failed to compress " << path << std::endl;
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    std::remove(path.c_str());
+    return true;
+#else
+    return false;
+#endif
+}
+
+// <base>_YYYY_MM_dd.<n>.log 或 <base>_YYYY_MM_dd.<n>.log.gz,正在写的文件没有序号
+bool LogArchiver::isRotatedFile(const std::string& name) const {
+    if (name.compare(0, prefix_.size(), prefix_) != 0) {
+        return false;
+    }
+    std::string stem = name;
+    if (stem.size() > 3 && stem.compare(stem.size() - 3, 3, ".gz") == 0) {
+        stem.resize(stem.size() - 3);
+    }
+    if (stem.size() < 4 || stem.compare(stem.size() - 4, 4, ".log") != 0) {
+        return false;
+    }
+    stem.resize(stem.size() - 4);
+
+    size_t dot = stem.rfind('.');
+    if (dot == std::string::npos || dot + 1 == stem.size()) {
+        return false;
+    }
+    return std::all_of(stem.begin() + dot + 1, stem.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+
+void LogArchiver::enforceRetention() {
+    if (policy_.max_files == 0 && policy_.max_total_size == 0) {
+        return;
+    }
+
+    struct Entry {
+        fs::path path;
+        fs::file_time_type mtime;
+        uintmax_t size;
+    };
+    std::vector<Entry> rotated;
+
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(dir_, ec)) {
+        if (!entry.is_regular_file(ec) || !isRotatedFile(entry.path().filename().string())) {
+            continue;
+        }
+        rotated.push_back({entry.path(), entry.last_write_time(ec), entry.file_size(ec)});
+    }
+
+    std::sort(rotated.begin(), rotated.end(), [](const Entry& a, const Entry& b) {
+        return a.mtime != b.mtime ? a.mtime > b.mtime : a.path > b.path;
+    });
+
+    size_t kept = 0;
+    uintmax_t kept_size = 0;
+    for (const auto& entry : rotated) {
+        bool keep = (policy_.max_files == 0 || kept < policy_.max_files)
+            && (policy_.max_total_size == 0 || kept_size + entry.size <= policy_.max_total_size);
+        if (keep) {
+            ++kept;
+            kept_size += entry.size;
+        } else {
+            fs::remove(entry.path, ec);
+        }
+    }
+}
+
+static std::time_t nextMidnight(std::time_t now) {
+    std::tm tm;
+    localtime_r(&now, &tm);
+    tm.tm_hour = 0;
+    tm.tm_min = 0;
+    tm.tm_sec = 0;
+    tm.tm_mday += 1;
+    tm.tm_isdst = -1;
+    return std::mktime(&tm);
+}
+
+static bool fileExists(const std::string& path) {
+    return access(path.c_str(), F_OK) == 0;
+}
+
+// 改名失败(例如目录只读)后,按大小轮转的重试间隔
+static const std::time_t ROTATE_RETRY_SECONDS = 60;
+
+// stem.<seq>.log 中第一个未被占用的名字,seq停在该序号上
+static std::string freeRotatedName(const std::string& stem, unsigned& seq) {
+    for (;; ++seq) {
+        std::string rotated = stem + "." + std::to_string(seq) + ".log";
+        if (!fileExists(rotated) && !fileExists(rotated + ".gz")) {
+            return rotated;
+        }
+    }
+}
+
+// <prefix>YYYY_MM_dd.log,即某一天正在写的文件
+static bool isActiveFileName(const std::string& name, const std::string& prefix) {
+    static const std::string DATE_PATTERN = "dddd_dd_dd";
+    if (name.size() != prefix.size() + DATE_PATTERN.size() + 4
+        || name.compare(0, prefix.size(), prefix) != 0
+        || name.compare(name.size() - 4, 4, ".log") != 0) {
+        return false;
+    }
+    for (size_t i = 0; i < DATE_PATTERN.size(); ++i) {
+        char c = name[prefix.size() + i];
+        if (DATE_PATTERN[i] == 'd' ? (c < '0' || c > '9') : c != '_') {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string RotatingFileLogHandler::ActiveFileName(const std::string& base_path, std::time_t when) {
+    std::tm tm;
+    localtime_r(&when, &tm);
+
+    std::ostringstream oss;
+    oss << base_path << "_" << std::put_time(&tm, "%Y_%m_%d") << ".log";
+    return oss.str();
+}
+
+RotatingFileLogHandler::RotatingFileLogHandler(const std::string& base_path,
+                                               const RotationPolicy& rotation,
+                                               const FlushPolicy& policy)
+    : FileLogHandler(ActiveFileName(base_path, std::time(nullptr)), policy)
+    , base_path_(base_path)
+    , rotation_(rotation)
+    , active_path_(ActiveFileName(base_path, std::time(nullptr)))
+    , next_midnight_(nextMidnight(std::time(nullptr)))
+    , next_seq_(1)
+    , retry_after_(0)
+    , archiver_(std::make_unique<LogArchiver>(base_path, rotation)) {
+    std::cout << "RotatingFileLogHandler" << std::endl << std::flush;
+    rotateStaleFiles();
+}
+
+RotatingFileLogHandler::~RotatingFileLogHandler() {
+    std::cout << "~RotatingFileLogHandler" << std::endl << std::flush;
+}
+
+void RotatingFileLogHandler::HandleBatch(const std::vector<LogRecord>& batch) {
+    FileLogHandler::HandleBatch(batch);
+    rotateIfDue();
+}
+
+void RotatingFileLogHandler::OnIdle() {
+    FileLogHandler::OnIdle();
+    rotateIfDue();
+}
+
+void RotatingFileLogHandler::rotateIfDue() {
+    bool date_changed = rotation_.rotate_at_midnight && std::time(nullptr) >= next_midnight_;
+    bool too_big = rotation_.max_file_size > 0 && file_size_ >= rotation_.max_file_size
+        && std::time(nullptr) >= retry_after_;
+    if (date_changed || too_big) {
+        rotate();
+    }
+}
+
+void RotatingFileLogHandler::rotate() {
+    // 先把缓冲区写入旧文件,保证轮转后的文件是完整的
+    Flush();
+
+    std::string stem = active_path_.substr(0, active_path_.size() - 4);  // 去掉 ".log"
+    // 序号只增不减,保留策略删掉的旧序号不会被新文件复用;改名成功才占用序号
+    unsigned seq = next_seq_;
+    std::string rotated = freeRotatedName(stem, seq);
+
+    std::time_t now = std::time(nullptr);
+    if (std::rename(active_path_.c_str(), rotated.c_str()) != 0) {
+        std::cerr << "Failed to rotate " << active_path_ << ": " << strerror(errno) << std::endl;
+        rotated.clear();
+        // 同一天内继续写原文件,过一段时间再试,而不是每批日志都重试一次
+        retry_after_ = now + ROTATE_RETRY_SECONDS;
+    } else {
+        next_seq_ = seq + 1;
+        retry_after_ = 0;
+    }
+
+    bool new_day = now >= next_midnight_;
+    if (new_day) {
+        next_seq_ = 1;
+        retry_after_ = 0;
+    }
+    active_path_ = ActiveFileName(base_path_, now);
+    next_midnight_ = nextMidnight(now);
+    reopen(active_path_);
+
+    if (!rotated.empty()) {
+        archiver_->Submit(rotated);
+    }
+    if (new_day) {
+        // 前一天的文件改名失败时留在原处,在这里补上
+        rotateStaleFiles();
+    }
+}
+
+void RotatingFileLogHandler::rotateStaleFiles() {
+    fs::path base(base_path_);
+    fs::path dir = base.has_parent_path() ? base.parent_path() : fs::path(".");
+    std::string prefix = base.filename().string() + "_";
+    std::string active_name = fs::path(active_path_).filename().string();
+
+    std::vector<fs::path> stale;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(dir, ec)) {
+        std::string name = entry.path().filename().string();
+        if (name != active_name && isActiveFileName(name, prefix) && entry.is_regular_file(ec)) {
+            stale.push_back(entry.path());
+        }
+    }
+
+    for (const auto& path : stale) {
+        std::string from = path.string();
+        unsigned seq = 1;
+        std::string rotated = freeRotatedName(from.substr(0, from.size() - 4), seq);
+        if (std::rename(from.c_str(), rotated.c_str()) != 0) {
+            std::cerr << "Failed to rotate " << from << ": " << strerror(errno) << std::endl;
+            continue;
+        }
+        archiver_->Submit(rotated);
+    }
+}
@@ -0,0 +1,71 @@
+/**
+ * @file RotatingLogHandler.h
+ * @author KevinGlaser
+ * @brief File log handler with size/date based rollover, background compression and retention
+ * @version 0.1
+ * @date 2026-10-19
+ * 
+ * @copyright Copyright (c) 2025
+ * 
+ */
+
+#ifndef __ROTATINGLOGHANDLER_H__
+#define __ROTATINGLOGHANDLER_H__
+
+#include <ctime>
+
+#include "LogUtil.h"
+
+/**
+ * @brief When RotatingFileLogHandler starts a new file and how many old ones it keeps
+ */
+struct RotationPolicy {
+    size_t max_file_size = 64 * 1024 * 1024;         // roll over at this size, 0 disables
+    bool rotate_at_midnight = true;                  // roll over when the local date changes
+    bool compress = true;                            // gzip rotated files on the archiver thread
+    size_t max_files = 30;                           // rotated files kept on disk, 0 = unlimited
+    size_t max_total_size = 1024 * 1024 * 1024;      // bytes of rotated files kept on disk, 0 = unlimited
+};
+
+class LogArchiver;
+
+/**
+ * @brief FileLogHandler writing to <base>_YYYY_MM_dd.log; on rollover the active file is renamed
+ *        to <base>_YYYY_MM_dd.<n>.log and handed to a background archiver that compresses it and
+ *        enforces the retention limits, so the logger thread only pays for a rename and an open
+ */
+class RotatingFileLogHandler : public FileLogHandler {
+public:
+    explicit RotatingFileLogHandler(const std::string& base_path,
+                                    const RotationPolicy& rotation = RotationPolicy(),
+                                    const FlushPolicy& policy = FlushPolicy());
+    virtual ~RotatingFileLogHandler() override;
+
+    void HandleBatch(const std::vector<LogRecord>& batch) override;
+    void OnIdle() override;
+
+    /**
+     * @brief name of the file currently written, for the given date
+     */
+    static std::string ActiveFileName(const std::string& base_path, std::time_t when);
+
+private:
+    void rotateIfDue();
+    void rotate();
+
+    /**
+     * @brief rename the active files of other days left behind by earlier runs, e.g. a process
+     *        stopped before midnight and restarted the next day, and hand them to the archiver
+     */
+    void rotateStaleFiles();
+
+    std::string base_path_;
+    RotationPolicy rotation_;
+    std::string active_path_;
+    std::time_t next_midnight_;
+    unsigned next_seq_;
+    std::time_t retry_after_;                        // 改名失败后,在此之前不再按大小轮转
+    std::unique_ptr<LogArchiver> archiver_;
+};
+
+#endif
@@ -0,0 +1,162 @@
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+
+#include "ShippingLogHandler.h"
+
+ShippingLogHandler::ShippingLogHandler(std::unique_ptr<LogHandler> fallback)
+    : fd_(-1)
+    , addr_len_(logship::CollectorAddress(addr_))
+    , seq_(0)
+    , lost_records_(0)
+    , collector_up_(false)
+    , fallback_(std::move(fallback)) {
+    fd_ = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd_ == -1) {
+        std::cerr << "Failed to create log shipping socket: " << strerror(errno) << std::endl;
+    }
+    datagram_.reserve(logship::MAX_DATAGRAM);
+    std::cout << "ShippingLogHandler" << std::endl << std::flush;
+}
+
+ShippingLogHandler::~ShippingLogHandler() {
+    if (fd_ != -1) {
+        close(fd_);
+    }
+    std::cout << "~ShippingLogHandler" << std::endl << std::flush;
+}
+
+void ShippingLogHandler::beginDatagram() {
+    logship::DatagramHeader header{};
+    header.magic = logship::MAGIC;
+    header.version = logship::FORMAT_VERSION;
+    header.header_size = sizeof(header);
+    header.pid = static_cast<uint32_t>(getpid());
+    datagram_.assign(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+bool ShippingLogHandler::sendDatagram(size_t record_count) {
+    if (fd_ == -1) {
+        return false;
+    }
+
+    // 发送前补上记录数、序号和此前未能发出的记录数
+    logship::DatagramHeader header;
+    memcpy(&header, datagram_.data(), sizeof(header));
+    header.record_count = static_cast<uint32_t>(record_count);
+    header.seq = seq_;
+    header.lost_records = lost_records_;
+    memcpy(&datagram_[0], &header, sizeof(header));
+
+    ssize_t n = sendto(fd_, datagram_.data(), datagram_.size(), MSG_DONTWAIT | MSG_NOSIGNAL,
+                       reinterpret_cast<const sockaddr*>(&addr_), addr_len_);
+    if (n >= 0) {
+        if (!collector_up_) {
+            std::cout << "Log collector connected" << std::endl;
+        }
+        collector_up_ = true;
+        lost_records_ = 0;
+        ++seq_;
+        return true;
+    }
+
+    if (errno == ECONNREFUSED || errno == ENOENT) {
+        if (collector_up_) {
+            std::cerr << "Log collector went away, using fallback handler" << std::endl;
+        }
+        collector_up_ = false;
+        return false;
+    }
+    // 收集端处理不过来时不等待,记为丢失并在下一个数据报中告知
+    lost_records_ += record_count;
+    return true;
+}
+
+void ShippingLogHandler::appendRecord(const LogRecord& record) {
+    size_t before = datagram_.size();
+    binlog::EncodeRecord(datagram_, record);
+    const size_t limit = logship::MAX_DATAGRAM - sizeof(logship::DatagramHeader);
+    size_t encoded = datagram_.size() - before;
+    if (encoded <= limit) {
+        return;
+    }
+
+    // 单独一条也放不进数据报: 截断正文,字段仍然放不下时一并去掉
+    static const std::string TRUNCATED_MARK = "...[truncated]";
+    static const std::vector<LogField> NO_FIELDS;
+    datagram_.resize(before);
+    size_t fields_size = encoded - binlog::RECORD_HEADER_SIZE - record.body.size();
+    bool keep_fields = binlog::RECORD_HEADER_SIZE + fields_size + TRUNCATED_MARK.size() <= limit;
+    size_t room = limit - binlog::RECORD_HEADER_SIZE - TRUNCATED_MARK.size() - (keep_fields ? fields_size : 0);
+    std::string body = record.body.substr(0, room) + TRUNCATED_MARK;
+    binlog::EncodeRecord(datagram_, binlog::ToNanoseconds(record.timestamp), binlog::ThreadIdToInt(record.thread_id),
+                         record.source_id, static_cast<uint8_t>(record.level), body,
+                         keep_fields ? record.fields : NO_FIELDS);
+}
+
+void ShippingLogHandler::HandleBatch(const std::vector<LogRecord>& batch) {
+    size_t first = 0;           // 当前数据报中第一条记录的下标
+    size_t count = 0;
+    bool delivered = true;
+    beginDatagram();
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+        size_t before = datagram_.size();
+        appendRecord(batch[i]);
+        if (datagram_.size() <= logship::MAX_DATAGRAM) {
+            ++count;
+            continue;
+        }
+
+        // 放不下时先发出已有的记录;appendRecord保证任何一条都能单独放进空数据报,这里count必然大于0
+        datagram_.resize(before);
+        if (!sendDatagram(count)) {
+            delivered = false;
+            break;
+        }
+        first = i;
+        beginDatagram();
+        appendRecord(batch[i]);
+        count = 1;
+    }
+
+    if (delivered && count > 0) {
+        delivered = sendDatagram(count);
+    }
+    if (delivered || !fallback_ || first >= batch.size()) {
+        return;
+    }
+
+    // 没有收集端在监听,剩余的记录交给本地handler
+    if (first == 0) {
+        fallback_->HandleBatch(batch);
+    } else {
+        std::vector<LogRecord> rest(batch.begin() + static_cast<std::ptrdiff_t>(first), batch.end());
+        fallback_->HandleBatch(rest);
+    }
+}
+
+void ShippingLogHandler::HandleLog(const std::string& message, LogLevel level) {
+    LogRecord record;
+    record.timestamp = std::chrono::system_clock::now();
+    record.thread_id = std::this_thread::get_id();
+    record.level = level;
+    record.source_id = 0;
+    record.queue_size = 0;
+    record.body = message;
+    record.message = message;
+    HandleBatch(std::vector<LogRecord>{record});
+}
+
+void ShippingLogHandler::OnIdle() {
+    if (fallback_) {
+        fallback_->OnIdle();
+    }
+}
+
+void ShippingLogHandler::Flush() {
+    if (fallback_) {
+        fallback_->Flush();
+    }
+}
@@ -0,0 +1,67 @@
+/**
+ * @file ShippingLogHandler.h
+ * @author KevinGlaser
+ * @brief Log handler shipping batched binary records to the Guardian's log collector
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef __SHIPPINGLOGHANDLER_H__
+#define __SHIPPINGLOGHANDLER_H__
+
+#include <sys/un.h>
+
+#include "LogShippingFormat.h"
+
+/**
+ * @brief Packs each batch into as few datagrams as possible (see LogShippingFormat.h) and sends
+ *        them without blocking to the collector socket, so the Guardian is the only process that
+ *        writes the merged log to disk. If the socket buffer is full the records are counted as
+ *        lost and reported in the next datagram. While no collector is listening, batches go to
+ *        the optional fallback handler instead, so nothing is lost when the Server runs alone.
+ *        A record too large for a datagram of its own is shipped with its message truncated.
+ */
+class ShippingLogHandler : public LogHandler {
+public:
+    explicit ShippingLogHandler(std::unique_ptr<LogHandler> fallback = nullptr);
+    virtual ~ShippingLogHandler() override;
+
+    void HandleLog(const std::string& message, LogLevel level) override;
+    void HandleBatch(const std::vector<LogRecord>& batch) override;
+    void OnIdle() override;
+    void Flush() override;
+
+    /**
+     * @brief text is only needed by the fallback handler
+     */
+    bool NeedsFormattedText() const override { return fallback_ != nullptr; }
+
+private:
+    void beginDatagram();
+
+    /**
+     * @brief encode record at the end of the pending datagram, truncated so that it always fits
+     *        into an otherwise empty datagram
+     */
+    void appendRecord(const LogRecord& record);
+
+    /**
+     * @brief send the pending datagram
+     * @return false if no collector is listening
+     */
+    bool sendDatagram(size_t record_count);
+
+    int fd_;
+    sockaddr_un addr_;
+    socklen_t addr_len_;
+    uint64_t seq_;
+    uint64_t lost_records_;
+    bool collector_up_;
+    std::string datagram_;
+    std::unique_ptr<LogHandler> fallback_;
+};
+
+#endif
@@ -0,0 +1,347 @@
+/**
+ * @file ControlChannelFormat.h
+ * @author KevinGlaser
+ * @brief Layout of the Guardian-Server control segment: a seqlock protected server info block and
+ *        two single-producer single-consumer rings of length-prefixed frames with futex doorbells
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef __CONTROLCHANNELFORMAT_H__
+#define __CONTROLCHANNELFORMAT_H__
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <type_traits>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * The segment test_shm is a Header followed by the data of two rings, to_server written only by the
+ * Guardian and to_guardian written only by the Server. The Guardian creates and initializes it
+ * before forking the Server and keeps it mapped for the Server's lifetime.
+ *
+ * The header's InfoBlock carries what the Server needs to start (ServerInfo: generation, ready flag,
+ * server id, version, port) under a sequence lock. Only the Guardian writes it: seq becomes odd,
+ * the fields are stored, seq becomes even again. A reader copies the fields between two loads of an
+ * even, unchanged seq, so it never sees half of an update and never blocks the writer. The fields
+ * are kept as relaxed atomic words so the racing copy is well defined. seq is also a futex word:
+ * the Server sleeps on it until the Guardian publishes a ready ServerInfo.
+ *
+ * A ring is capacity bytes (a power of two) of a byte stream; byte i lives at data[i % capacity].
+ * A frame is a 4 byte length followed by that many bytes, e.g. "OnStop". The
+ * producer copies a frame behind write_pos and then publishes the new write_pos with release; the
+ * consumer loads write_pos with acquire, copies the frames up to it and publishes read_pos with
+ * release, which frees the space for the producer. Neither side takes a lock or makes a syscall
+ * while the other one is awake.
+ *
+ * Each ring has a doorbell: seq is a futex word the producer bumps after every push. A consumer that
+ * found the ring empty registers in waiters and sleeps in FUTEX_WAIT on the seq it loaded before
+ * looking; the producer calls FUTEX_WAKE only when waiters is non-zero. A push between the load and
+ * the wait changes seq, so the kernel returns at once instead of sleeping.
+ */
+namespace control {
+
+constexpr char MAGIC[8] = {'C', 'M', 'S', 'C', 'T', 'R', 'L', '3'};
+constexpr uint32_t FORMAT_VERSION = 3;
+constexpr size_t SEGMENT_SIZE = 64 * 1024;
+
+// 原先字符串协议中的命令和回应,现在各占一帧
+constexpr char STOP_COMMAND[] = "OnStop";
+constexpr char STOPPED_REPLY[] = "OnStopped Success";
+constexpr char STOPPED_EXCEPTION_REPLY[] = "OnStopped Exception";
+
+// 服务端启动所需的信息,由InfoBlock的顺序锁保护
+struct ServerInfo {
+    uint64_t generation;            // 每次发布加一,0表示从未发布
+    uint32_t ready;                 // 非0表示其余字段已经可用
+    uint16_t port;                  // Guardian监听的TCP端口
+    uint16_t reserved;
+    char server_id[32];             // 以'\0'结尾
+    char version[16];
+};
+
+constexpr size_t INFO_WORDS = (sizeof(ServerInfo) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+struct InfoBlock {
+    alignas(64) std::atomic<uint32_t> seq;          // 奇数表示正在写入,同时是futex字
+    std::atomic<uint32_t> waiters;                  // 正在futex上等待的读者数
+    std::atomic<uint64_t> words[INFO_WORDS];        // ServerInfo的逐字拷贝
+};
+
+// 生产者和消费者的位置放在不同缓存行,互不干扰
+struct Ring {
+    alignas(64) std::atomic<uint64_t> write_pos;    // 生产者写入的总字节数
+    alignas(64) std::atomic<uint64_t> read_pos;     // 消费者读走的总字节数
+    alignas(64) std::atomic<uint32_t> seq;          // futex字,每次写入加一
+    std::atomic<uint32_t> waiters;                  // 正在futex上等待的消费者数
+    uint32_t capacity;
+    uint32_t data_offset;                           // 相对于段起始位置
+};
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    InfoBlock info;
+    Ring to_server;
+    Ring to_guardian;
+};
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free,
+              "futex words must be plain lock free 32 bit atomics");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "control rings need lock free 64 bit atomics");
+static_assert(std::is_trivially_copyable<ServerInfo>::value, "ServerInfo is copied word by word");
+
+inline char* Data(Header* header, const Ring& ring) {
+    return reinterpret_cast<char*>(header) + ring.data_offset;
+}
+
+inline bool ValidRing(const Ring& ring, size_t mapped_size) {
+    return ring.capacity > sizeof(uint32_t) && (ring.capacity & (ring.capacity - 1)) == 0
+        && uint64_t(ring.data_offset) + ring.capacity <= mapped_size;
+}
+
+inline bool Valid(const Header* header, size_t mapped_size) {
+    return mapped_size >= sizeof(Header)
+        && memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0
+        && header->version == FORMAT_VERSION
+        && header->header_size >= sizeof(Header)
+        && ValidRing(header->to_server, mapped_size)
+        && ValidRing(header->to_guardian, mapped_size);
+}
+
+/**
+ * @brief lay out a Header and the two rings in a zeroed segment of size bytes, magic is written last
+ */
+inline void Initialize(Header* header, size_t size) {
+    header->version = FORMAT_VERSION;
+    header->header_size = sizeof(Header);
+    // 两个方向平分头部之后的空间,各取不超过一半的最大2的幂
+    uint32_t capacity = 1;
+    while (sizeof(Header) + 4 * uint64_t(capacity) <= size) {
+        capacity *= 2;
+    }
+    header->to_server.capacity = capacity;
+    header->to_server.data_offset = static_cast<uint32_t>(sizeof(Header));
+    header->to_guardian.capacity = capacity;
+    header->to_guardian.data_offset = static_cast<uint32_t>(sizeof(Header) + capacity);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(header->magic, MAGIC, sizeof(MAGIC));
+}
+
+/**
+ * @brief copy value into a fixed size field, truncated and always '\0' terminated
+ */
+template <size_t N>
+inline void SetField(char (&field)[N], const std::string& value) {
+    size_t size = std::min(value.size(), N - 1);
+    memcpy(field, value.data(), size);
+    memset(field + size, 0, N - size);
+}
+
+template <size_t N>
+inline std::string GetField(const char (&field)[N]) {
+    return std::string(field, strnlen(field, N));
+}
+
+inline void WakeAll(std::atomic<uint32_t>& word) {
+    // 段由两个进程共享,不能用FUTEX_PRIVATE_FLAG
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+/**
+ * @brief sleep while word still holds seen, registered in waiters so the writer knows to wake us
+ *
+ * @param deadline only used when timeout_ms >= 0
+ * @return false the deadline passed or the wait failed
+ */
+inline bool WaitChange(std::atomic<uint32_t>& word, std::atomic<uint32_t>& waiters, uint32_t seen, int timeout_ms,
+                       std::chrono::steady_clock::time_point deadline) {
+    timespec timeout{};
+    if (timeout_ms >= 0) {
+        auto left = deadline - std::chrono::steady_clock::now();
+        if (left <= std::chrono::steady_clock::duration::zero()) {
+            return false;
+        }
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(left).count();
+        timeout.tv_sec = static_cast<time_t>(ns / 1000000000);
+        timeout.tv_nsec = static_cast<long>(ns % 1000000000);
+    }
+    waiters.fetch_add(1, std::memory_order_seq_cst);
+    // word已经变化时内核立即返回EAGAIN,不会错过两次读取之间的写入
+    long rc = syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, seen,
+                      timeout_ms >= 0 ? &timeout : nullptr, nullptr, 0);
+    int err = errno;
+    waiters.fetch_sub(1, std::memory_order_seq_cst);
+    return rc == 0 || err == EAGAIN || err == EINTR || err == ETIMEDOUT;
+}
+
+/**
+ * @brief replace the ServerInfo; single writer, readers are never blocked
+ */
+inline void PublishInfo(InfoBlock& block, const ServerInfo& info) {
+    uint64_t words[INFO_WORDS] = {};
+    memcpy(words, &info, sizeof(info));
+
+    uint32_t seq = block.seq.load(std::memory_order_relaxed);
+    block.seq.store(seq + 1, std::memory_order_relaxed);
+    // 奇数的seq先于任何字段可见
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < INFO_WORDS; ++i) {
+        block.words[i].store(words[i], std::memory_order_relaxed);
+    }
+    // 与读者登记waiters的顺序构成全序,见Push
+    block.seq.store(seq + 2, std::memory_order_seq_cst);
+    if (block.waiters.load(std::memory_order_seq_cst) != 0) {
+        WakeAll(block.seq);
+    }
+}
+
+/**
+ * @brief copy a consistent ServerInfo without blocking
+ *
+ * @return false the writer was in the middle of an update every time we looked
+ */
+inline bool ReadInfo(const InfoBlock& block, ServerInfo& info) {
+    uint64_t words[INFO_WORDS];
+    for (int attempt = 0; attempt < 1000; ++attempt) {
+        uint32_t before = block.seq.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        for (size_t i = 0; i < INFO_WORDS; ++i) {
+            words[i] = block.words[i].load(std::memory_order_relaxed);
+        }
+        // 字段的读取不能越过第二次读取seq
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (block.seq.load(std::memory_order_relaxed) == before) {
+            memcpy(&info, words, sizeof(info));
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief wait until the Guardian has published a ready ServerInfo and copy it
+ *
+ * @param timeout_ms -1 waits forever
+ * @return false the timeout expired first
+ */
+inline bool WaitInfoReady(InfoBlock& block, ServerInfo& info, int timeout_ms) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (true) {
+        uint32_t seen = block.seq.load(std::memory_order_acquire);
+        if (ReadInfo(block, info) && info.ready != 0) {
+            return true;
+        }
+        if (!WaitChange(block.seq, block.waiters, seen, timeout_ms, deadline)) {
+            return false;
+        }
+    }
+}
+
+inline void CopyIn(char* data, uint32_t capacity, uint64_t pos, const void* src, size_t size) {
+    size_t offset = static_cast<size_t>(pos & (capacity - 1));
+    size_t first = std::min<size_t>(size, capacity - offset);
+    memcpy(data + offset, src, first);
+    memcpy(data, static_cast<const char*>(src) + first, size - first);
+}
+
+inline void CopyOut(const char* data, uint32_t capacity, uint64_t pos, void* dst, size_t size) {
+    size_t offset = static_cast<size_t>(pos & (capacity - 1));
+    size_t first = std::min<size_t>(size, capacity - offset);
+    memcpy(dst, data + offset, first);
+    memcpy(static_cast<char*>(dst) + first, data, size - first);
+}
+
+/**
+ * @brief append one frame and ring the doorbell; only one thread of the producing process may push
+ *        at a time. Async-signal-safe.
+ *
+ * @return false not enough free space, nothing was written
+ */
+inline bool Push(Header* header, Ring& ring, const void* frame, uint32_t size) {
+    uint64_t write_pos = ring.write_pos.load(std::memory_order_relaxed);
+    uint64_t read_pos = ring.read_pos.load(std::memory_order_acquire);
+    if (uint64_t(ring.capacity) - (write_pos - read_pos) < sizeof(uint32_t) + uint64_t(size)) {
+        return false;
+    }
+    char* data = Data(header, ring);
+    CopyIn(data, ring.capacity, write_pos, &size, sizeof(size));
+    CopyIn(data, ring.capacity, write_pos + sizeof(size), frame, size);
+    ring.write_pos.store(write_pos + sizeof(size) + size, std::memory_order_release);
+
+    // 与消费者登记waiters的顺序构成全序:要么看到等待者并唤醒,要么对方在futex中看到新的seq
+    ring.seq.fetch_add(1, std::memory_order_seq_cst);
+    if (ring.waiters.load(std::memory_order_seq_cst) != 0) {
+        WakeAll(ring.seq);
+    }
+    return true;
+}
+
+/**
+ * @brief take the oldest frame without blocking; only one thread of the consuming process may pop
+ *        at a time
+ *
+ * @return false the ring is empty
+ */
+inline bool Pop(Header* header, Ring& ring, std::string& frame) {
+    uint64_t read_pos = ring.read_pos.load(std::memory_order_relaxed);
+    uint64_t write_pos = ring.write_pos.load(std::memory_order_acquire);
+    if (write_pos == read_pos) {
+        return false;
+    }
+    const char* data = Data(header, ring);
+    uint32_t size = 0;
+    uint64_t available = write_pos - read_pos;
+    if (available >= sizeof(size)) {
+        CopyOut(data, ring.capacity, read_pos, &size, sizeof(size));
+    }
+    if (available < sizeof(size) || size > available - sizeof(size)) {
+        // 长度与已发布的数据不符,只可能是段被破坏,丢弃全部未读数据
+        ring.read_pos.store(write_pos, std::memory_order_release);
+        return false;
+    }
+    frame.resize(size);
+    CopyOut(data, ring.capacity, read_pos + sizeof(size), &frame[0], size);
+    ring.read_pos.store(read_pos + sizeof(size) + size, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief take the oldest frame, sleeping until one is pushed
+ *
+ * @param timeout_ms -1 waits forever
+ * @return false the timeout expired first
+ */
+inline bool Receive(Header* header, Ring& ring, std::string& frame, int timeout_ms) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (true) {
+        uint32_t seen = ring.seq.load(std::memory_order_acquire);
+        if (Pop(header, ring, frame)) {
+            return true;
+        }
+
+        if (!WaitChange(ring.seq, ring.waiters, seen, timeout_ms, deadline)) {
+            return false;
+        }
+    }
+}
+
+} // namespace control
+
+#endif
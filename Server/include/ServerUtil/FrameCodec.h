@@ -0,0 +1,199 @@
+/**
+ * @file FrameCodec.h
+ * @author KevinGlaser
+ * @brief Length-prefixed framing of the Guardian-Server TCP control connection
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef __FRAMECODEC_H__
+#define __FRAMECODEC_H__
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+/**
+ * Every message on the connection, e.g. {"action":"heartbeat","msg":"ping"}, is sent as a frame: a 4
+ * byte big-endian payload length followed by the payload. TCP may split a frame across reads or put
+ * several frames in one read; a Decoder collects whatever arrived in one reusable buffer and hands out
+ * the complete frames, keeping a partial one for the next read.
+ */
+namespace framing {
+
+constexpr size_t HEADER_SIZE = sizeof(uint32_t);
+// 控制消息都很短,超过上限只可能是对端出错或不是本协议
+constexpr uint32_t MAX_FRAME_SIZE = 1024 * 1024;
+
+/**
+ * @brief prefix payload with its length
+ */
+inline std::string Encode(const std::string& payload) {
+    uint32_t length = htonl(static_cast<uint32_t>(payload.size()));
+    std::string frame(reinterpret_cast<const char*>(&length), HEADER_SIZE);
+    frame.append(payload);
+    return frame;
+}
+
+class Decoder {
+public:
+    Decoder() : begin(0), end(0), failed(false) {}
+
+    /**
+     * @brief free space for the next read, at least min_space bytes; unread bytes are kept
+     */
+    char* WritableSpace(size_t min_space = 4096) {
+        if (begin == end) {
+            begin = end = 0;
+        }
+        if (buffer.size() - end < min_space) {
+            // 先把未读数据挪到开头,仍然不够再扩容
+            if (begin > 0) {
+                memmove(buffer.data(), buffer.data() + begin, end - begin);
+                end -= begin;
+                begin = 0;
+            }
+            if (buffer.size() - end < min_space) {
+                buffer.resize(std::max(buffer.size() * 2, end + min_space));
+            }
+        }
+        return buffer.data() + end;
+    }
+
+    size_t WritableSize() const { return buffer.size() - end; }
+
+    /**
+     * @brief mark size bytes written to WritableSpace() as received
+     */
+    void Commit(size_t size) { end += size; }
+
+    /**
+     * @brief take the next complete frame's payload
+     *
+     * @return false no complete frame buffered, or Failed()
+     */
+    bool Next(std::string& payload) {
+        if (failed || end - begin < HEADER_SIZE) {
+            return false;
+        }
+        uint32_t length;
+        memcpy(&length, buffer.data() + begin, HEADER_SIZE);
+        length = ntohl(length);
+        if (length > MAX_FRAME_SIZE) {
+            failed = true;
+            return false;
+        }
+        if (end - begin - HEADER_SIZE < length) {
+            return false;
+        }
+        payload.assign(buffer.data() + begin + HEADER_SIZE, length);
+        begin += HEADER_SIZE + length;
+        return true;
+    }
+
+    /**
+     * @brief a frame longer than MAX_FRAME_SIZE was announced, the stream cannot be resynchronized
+     */
+    bool Failed() const { return failed; }
+
+    /**
+     * @brief drop buffered bytes for a new connection, keeps the allocation
+     */
+    void Reset() {
+        begin = end = 0;
+        failed = false;
+    }
+
+private:
+    std::vector<char> buffer;
+    size_t begin;
+    size_t end;
+    bool failed;
+};
+
+enum class ReadStatus {
+    DATA,           // 读到了数据
+    WOULD_BLOCK,    // 非阻塞套接字上暂时没有数据
+    CLOSED,         // 对端关闭连接
+    ERROR,          // errno说明原因
+};
+
+/**
+ * @brief one recv() into the decoder's buffer
+ */
+inline ReadStatus ReadSome(int fd, Decoder& decoder) {
+    while (true) {
+        char* space = decoder.WritableSpace();
+        ssize_t n = recv(fd, space, decoder.WritableSize(), 0);
+        if (n > 0) {
+            decoder.Commit(static_cast<size_t>(n));
+            return ReadStatus::DATA;
+        }
+        if (n == 0) {
+            return ReadStatus::CLOSED;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return ReadStatus::WOULD_BLOCK;
+        }
+        return ReadStatus::ERROR;
+    }
+}
+
+/**
+ * @brief send all of data, also on a non-blocking socket whose send buffer is momentarily full
+ *
+ * @param timeout_ms longest wait for the socket to become writable
+ * @return false errno says why
+ */
+inline bool SendAll(int fd, const std::string& data, int timeout_ms = 1000) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        // 对端已关闭时返回EPIPE,不让SIGPIPE结束进程
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += static_cast<size_t>(n);
+            continue;
+        }
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            pollfd pfd{fd, POLLOUT, 0};
+            int ready = poll(&pfd, 1, timeout_ms);
+            if (ready == 0) {
+                errno = ETIMEDOUT;
+                return false;
+            }
+            if (ready == -1 && errno != EINTR) {
+                return false;
+            }
+            continue;
+        }
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Encode() payload and SendAll() it
+ */
+inline bool SendFrame(int fd, const std::string& payload, int timeout_ms = 1000) {
+    return SendAll(fd, Encode(payload), timeout_ms);
+}
+
+} // namespace framing
+
+#endif
@@ -13,10 +13,15 @@
 #include <filesystem>
 
 static const char* SHM_NAME = "test_shm";
-static const size_t SHM_SIZE = 4096;
+static const size_t SHM_SIZE = control::SEGMENT_SIZE;
+// 等待Guardian发布启动信息的最长时间
+static const int SERVER_INFO_TIMEOUT_MS = 10000;
+// 心跳和重连路径上的失败日志,每个调用点每个周期最多输出的条数
+static const uint32_t LOG_BURST_LIMIT = 5;
+static const std::chrono::seconds LOG_BURST_INTERVAL(30);
 
 SharedMemoryBuffer::SharedMemoryBuffer(const char* name, size_t size) 
-    : name(name), size(size) {
+    : name(name), size(size), header(nullptr) {
 #ifdef WIN32_PLATFORM
     hMapFile = CreateFileMapping(
         INVALID_HANDLE_VALUE,
@@ -53,6 +58,15 @@ SharedMemoryBuffer::SharedMemoryBuffer(const char* name, size_t size)
         throw std::runtime_error("Failed to map shared memory");
     }
 #endif
+    header = reinterpret_cast<control::Header*>(getData());
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!control::Valid(header, size)) {
+#ifndef WIN32_PLATFORM
+        munmap(data, size);
+        close(shm_fd);
+#endif
+        throw std::runtime_error("Shared memory has no valid control header");
+    }
 }
 
 SharedMemoryBuffer::~SharedMemoryBuffer() {
@@ -73,32 +87,50 @@ SharedMemoryBuffer::~SharedMemoryBuffer() {
 #endif
 }
 
-void SharedMemoryBuffer::write(const std::string& message) {
-#ifdef WIN32_PLATFORM
-    strncpy_s(static_cast<char*>(pBuf), size, message.c_str(), message.length());
-#else
-    strncpy(data, message.c_str(), size);
-#endif
+bool SharedMemoryBuffer::waitServerInfo(control::ServerInfo& info, int timeout_ms) {
+    return control::WaitInfoReady(header->info, info, timeout_ms);
 }
 
-std::string SharedMemoryBuffer::read() const {
-#ifdef WIN32_PLATFORM
-    return std::string(static_cast<char*>(pBuf));
-#else
-    return std::string(data);
-#endif
+bool SharedMemoryBuffer::receive(std::string& frame, int timeout_ms) {
+    return control::Receive(header, header->to_server, frame, timeout_ms);
+}
+
+bool SharedMemoryBuffer::send(const char* frame, size_t length) {
+    while (sending.test_and_set(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+    bool queued = control::Push(header, header->to_guardian, frame, static_cast<uint32_t>(length));
+    sending.clear(std::memory_order_release);
+    return queued;
+}
+
+bool SharedMemoryBuffer::sendFromSignal(const char* frame, size_t length) {
+    // 被打断的线程可能正持有发送权,此时等待会死锁
+    if (sending.test_and_set(std::memory_order_acquire)) {
+        return false;
+    }
+    bool queued = control::Push(header, header->to_guardian, frame, static_cast<uint32_t>(length));
+    sending.clear(std::memory_order_release);
+    return queued;
 }
 
 // ServerUtil implementation
-ServerUtil::ServerUtil() : buffer(SHM_NAME, SHM_SIZE), server_socket(-1), port(0) {}
+ServerUtil* ServerUtil::instance = nullptr;
 
-void ServerUtil::sendMessageToGuardian(const std::string& message) {
-    buffer.write(message);
+ServerUtil::ServerUtil() : buffer(SHM_NAME, SHM_SIZE), server_socket(-1), port(0), missed_heartbeat_count(0)
+    , heartbeat_alive(false), last_heartbeat_response(0) {}
+
+void ServerUtil::sendMessageToGuardian(const char* message) {
+    if (!buffer.send(message, strlen(message))) {
+        LOG_WARN("Control ring to guardian is full, dropped: " << message);
+    }
 }
 
-void ServerUtil::handleSignal(int signum, siginfo_t* info, void* context) {
-    ServerUtil* server = static_cast<ServerUtil*>(info->si_value.sival_ptr);
-    server->sendMessageToGuardian("OnStopped Exception");
+void ServerUtil::handleSignal(int signum, siginfo_t* /*info*/, void* /*context*/) {
+    // kill()发来的信号不带sival_ptr,实例由start()登记
+    if (instance != nullptr) {
+        instance->buffer.sendFromSignal(control::STOPPED_EXCEPTION_REPLY, sizeof(control::STOPPED_EXCEPTION_REPLY) - 1);
+    }
     std::cerr << "ServerUtil received signal: " << signum << std::endl;
     exit(1);
 }
@@ -115,8 +147,8 @@ void ServerUtil::registerSignalHandlers() {
 
 bool ServerUtil::connectToPort(unsigned short port) {
     std::cout << port << std::endl;
-    server_socket = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_socket == -1) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1) {
         throw std::runtime_error("Failed to create socket: " + std::string(strerror(errno)));
     }
 
@@ -125,19 +157,22 @@ bool ServerUtil::connectToPort(unsigned short port) {
     server_addr.sin_port = htons(port);
     inet_pton(AF_INET, "127.0.0.1", &server_addr.sin_addr);
 
-    if (connect(server_socket, reinterpret_cast<struct sockaddr*>(&server_addr), sizeof(server_addr)) == -1) {
-        std::cout << "Failed to connect to the specified port in connectToPort" << std::endl;
-        close(server_socket);
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&server_addr), sizeof(server_addr)) == -1) {
+        LOG_RATE_LIMITED(ERROR, LOG_BURST_LIMIT, LOG_BURST_INTERVAL,
+                         "Failed to connect to port " << port << ": " << strerror(errno));
+        close(fd);
         return false;
     }
+    std::lock_guard<std::mutex> lock(socket_mtx);
+    server_socket = fd;
     return true;
 }
 
 bool ServerUtil::reconnectToPort(unsigned short port) {
     while (true) {
-        std::cout << "Attempting to reconnect..." << std::endl;
+        LOG_DEDUP(WARN, "Attempting to reconnect to port " << port);
         if (connectToPort(port)) {
-            std::cout << "Reconnected successfully." << std::endl;
+            LOG_INFO("Reconnected successfully.");
             return true;
         }
         std::this_thread::sleep_for(std::chrono::seconds(1));
@@ -150,24 +185,22 @@ void ServerUtil::sendMessage(const char* action, unsigned short port) {
         {"action", action},
         {"msg", message.c_str()}
     };
-    std::string msg = j.dump();
-    const char* msg_to_send = msg.c_str();
-    if (send(server_socket, msg_to_send, strlen(msg_to_send), 0) < 0) {
+    if (!framing::SendFrame(server_socket, j.dump())) {
         throw std::runtime_error("Failed to send message: " + std::string(strerror(errno)));
     }
 }
 
 bool ServerUtil::waitForStartupConfirmation() {
-    char buffer[1024];
-    ssize_t numBytes = recv(server_socket, buffer, sizeof(buffer) - 1, 0);
-    if (numBytes <= 0) {
-        std::cerr << "Failed to receive startup confirmation" << std::endl;
-        return false;
+    std::string payload;
+    while (!tcp_decoder.Next(payload)) {
+        if (tcp_decoder.Failed() || framing::ReadSome(server_socket, tcp_decoder) != framing::ReadStatus::DATA) {
+            std::cerr << "Failed to receive startup confirmation" << std::endl;
+            return false;
+        }
     }
 
-    buffer[numBytes] = '\0';
     try {
-        auto response = json::parse(buffer);
+        auto response = json::parse(payload);
         if (response["action"] == "startup" && response["msg"] == "confirmed") {
             std::cout << "Received startup confirmation from guardian" << std::endl;
             return true;
@@ -191,27 +224,35 @@ void ServerUtil::startHeartbeat() {
             };
             
             try {
-                if (send(server_socket, heartbeat.dump().c_str(), heartbeat.dump().size(), 0) < 0) {
-                    std::cerr << "Failed to send heartbeat" << std::endl;
+                std::lock_guard<std::mutex> lock(socket_mtx);
+                // 接收线程正在重连时没有可用的连接,照常计为未送达
+                if (server_socket == -1 || !framing::SendFrame(server_socket, heartbeat.dump())) {
+                    LOG_RATE_LIMITED(ERROR, LOG_BURST_LIMIT, LOG_BURST_INTERVAL,
+                                     "Failed to send heartbeat: " << strerror(errno));
                     missed_heartbeat_count++;
                 }
             } catch (const std::exception& e) {
-                std::cerr << "Error sending heartbeat: " << e.what() << std::endl;
+                LOG_RATE_LIMITED(ERROR, LOG_BURST_LIMIT, LOG_BURST_INTERVAL, "Error sending heartbeat: " << e.what());
                 missed_heartbeat_count++;
             }
 
             if (std::time(nullptr) - last_heartbeat_response > 5) {
                 missed_heartbeat_count++;
-                std::cout << "No heartbeat response, count: " << missed_heartbeat_count << std::endl;
+                LOG_RATE_LIMITED(WARN, LOG_BURST_LIMIT, LOG_BURST_INTERVAL,
+                                 "No heartbeat response, count: " << missed_heartbeat_count);
             }
 
             if (missed_heartbeat_count >= MAX_MISSED_HEARTBEATS) {
-                std::cout << "Max missed heartbeats reached, attempting reconnection..." << std::endl;
-                close(server_socket);
-                if (reconnectToPort(port)) {
-                    missed_heartbeat_count = 0;
-                    last_heartbeat_response = std::time(nullptr);
+                LOG_DEDUP(WARN, "Max missed heartbeats reached, attempting reconnection...");
+                // 只唤醒阻塞在recv上的接收线程,由它重置解码器并重连,这里不关闭也不更换套接字
+                {
+                    std::lock_guard<std::mutex> lock(socket_mtx);
+                    if (server_socket != -1) {
+                        shutdown(server_socket, SHUT_RDWR);
+                    }
                 }
+                missed_heartbeat_count = 0;
+                last_heartbeat_response = std::time(nullptr);
             }
 
             std::this_thread::sleep_for(std::chrono::seconds(3));
@@ -223,57 +264,75 @@ void ServerUtil::handleHeartbeatResponse(const json& j) {
     if (j["action"] == "heartbeat" && j["msg"] == "pong") {
         missed_heartbeat_count = 0;
         last_heartbeat_response = std::time(nullptr);
-        std::cout << "Received heartbeat response" << std::endl;
+        LOG_DEDUP(DEBUG, "Received heartbeat response");
+    }
+}
+
+void ServerUtil::closeServerSocket() {
+    std::lock_guard<std::mutex> lock(socket_mtx);
+    if (server_socket != -1) {
+        close(server_socket);
+        server_socket = -1;
     }
 }
 
 void ServerUtil::receiveMessages() {
-    char buffer[1024];
+    std::string payload;
     while (true) {
-        ssize_t numBytes = recv(server_socket, buffer, sizeof(buffer) - 1, 0);
-        if (numBytes <= 0) {
-            if (numBytes == 0 || (numBytes == -1 && (errno == ECONNRESET))) {
-                close(server_socket);
-                std::cout << "Connection closed. Attempting to reconnect..." << std::endl;
-                if (reconnectToPort(port)) {
-                    missed_heartbeat_count = 0;
-                    last_heartbeat_response = std::time(nullptr);
+        framing::ReadStatus status = framing::ReadSome(server_socket, tcp_decoder);
+        if (status == framing::ReadStatus::DATA) {
+            // 一次读取可能带来多条消息,也可能只有半条
+            while (tcp_decoder.Next(payload)) {
+                LOG_DEDUP(DEBUG, "Received message: " << payload);
+                try {
+                    auto j = json::parse(payload);
+                    handleHeartbeatResponse(j);
+                } catch (const json::parse_error& e) {
+                    LOG_RATE_LIMITED(ERROR, LOG_BURST_LIMIT, LOG_BURST_INTERVAL, "Failed to parse message: " << e.what());
                 }
-                continue;
-            } else {
-                close(server_socket);
-                std::cerr << "recv() failed: " << strerror(errno) << std::endl;
-                break;
             }
-        } else {
-            buffer[numBytes] = '\0';
-            std::cout << "Received message: " << buffer << std::endl;
-            
-            try {
-                auto j = json::parse(buffer);
-                handleHeartbeatResponse(j);
-            } catch (const json::parse_error& e) {
-                std::cerr << "Failed to parse message: " << e.what() << std::endl;
+            if (!tcp_decoder.Failed()) {
+                continue;
             }
+            LOG_ERROR("Oversized frame from guardian, dropping the connection");
+        } else if (status == framing::ReadStatus::WOULD_BLOCK) {
+            continue;
+        }
+
+        if (status == framing::ReadStatus::ERROR && errno != ECONNRESET) {
+            LOG_ERROR("recv() failed: " << strerror(errno));
+        }
+        // 连接关闭、出错、心跳超时被shutdown或帧无法解析,丢弃残留数据后重连;重连只在这里进行
+        closeServerSocket();
+        tcp_decoder.Reset();
+        LOG_DEDUP(WARN, "Connection closed. Attempting to reconnect...");
+        if (reconnectToPort(port)) {
+            missed_heartbeat_count = 0;
+            last_heartbeat_response = std::time(nullptr);
         }
     }
 }
 
 void ServerUtil::start() {
     try {
+        instance = this;
         registerSignalHandlers();
 
         std::cout << "Initializing resources..." << std::endl;
-        std::this_thread::sleep_for(std::chrono::seconds(2));
-
-        std::string info_str = buffer.read();
-        json server_info = json::parse(info_str);
+        // Guardian通常在创建本进程之前就已发布,否则在顺序锁的futex上等它发布
+        control::ServerInfo server_info{};
+        if (!buffer.waitServerInfo(server_info, SERVER_INFO_TIMEOUT_MS)) {
+            throw std::runtime_error("Guardian did not publish server info in shared memory");
+        }
 
-        port = server_info["msg"]["port"].get<unsigned short>();
+        port = server_info.port;
         if (port == 0) {
             throw std::runtime_error("Invalid port number in shared memory");
         }
 
+        std::cout << "Server " << control::GetField(server_info.server_id) << " version "
+                  << control::GetField(server_info.version) << ", info generation " << server_info.generation
+                  << std::endl;
         std::cout << "Read port number from shared memory: " << port << std::endl;
 
         if (!connectToPort(port)) {
@@ -293,25 +352,24 @@ void ServerUtil::start() {
         std::thread receiveThread(&ServerUtil::receiveMessages, this);
         receiveThread.detach();
 
-        while (true) {
-            std::string message = buffer.read();
-            if (message == "OnStop") {
-                std::cout << "ServerUtil received OnStop message" << std::endl;
+        // 阻塞在to_server环的futex上,Guardian写入帧时立即唤醒,空闲时没有任何唤醒
+        std::string command;
+        while (buffer.receive(command, -1)) {
+            if (command == control::STOP_COMMAND) {
+                std::cout << "ServerUtil received stop command" << std::endl;
                 std::cout << "Saving state..." << std::endl;
                 std::this_thread::sleep_for(std::chrono::seconds(2));
-                sendMessageToGuardian("OnStopped Success");
+                sendMessageToGuardian(control::STOPPED_REPLY);
                 std::cout << "ServerUtil stopped successfully" << std::endl;
-                close(server_socket);
+                closeServerSocket();
                 return;
             }
-
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+            LOG_DEDUP(WARN, "Unknown command from guardian: " << command);
         }
+        throw std::runtime_error("Failed to wait on the control ring");
     } catch (const std::exception& e) {
         std::cerr << "Exception occurred: " << e.what() << std::endl;
-        if (server_socket != -1) {
-            close(server_socket);
-        }
+        closeServerSocket();
         exit(EXIT_FAILURE);
     }
 }
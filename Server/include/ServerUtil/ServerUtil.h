@@ -6,6 +6,8 @@
 #include <cstdlib>
 #include <ctime>
 #include <thread>
+#include <mutex>
+#include <atomic>
 
 #ifdef WIN32_PLATFORM
     #include <winsock2.h>
@@ -21,6 +23,9 @@
 #endif
 
 #include "../JsonUtil/json.hpp"
+#include "../LogUtil/LogUtil.h"
+#include "ControlChannelFormat.h"
+#include "FrameCodec.h"
 
 using json = nlohmann::json;
 
@@ -35,12 +40,43 @@ private:
     #endif
     const char* name;
     const size_t size;
+    control::Header* header;
+    // 环只允许一个生产者,本进程内的发送方在这里排队
+    std::atomic_flag sending = ATOMIC_FLAG_INIT;
 
 public:
     SharedMemoryBuffer(const char* name, size_t size);
     ~SharedMemoryBuffer();
-    void write(const std::string& message);
-    std::string read() const;
+
+    /**
+     * @brief wait until the guardian has published its startup information
+     * 
+     * @param timeout_ms -1 waits forever
+     * @return false timeout
+     */
+    bool waitServerInfo(control::ServerInfo& info, int timeout_ms);
+
+    /**
+     * @brief take the next frame the guardian queued
+     * 
+     * @param timeout_ms -1 waits forever, 0 only checks
+     * @return false timeout
+     */
+    bool receive(std::string& frame, int timeout_ms);
+
+    /**
+     * @brief queue one frame for the guardian, waits while another thread of this process is sending
+     * 
+     * @return false the ring is full
+     */
+    bool send(const char* frame, size_t length);
+
+    /**
+     * @brief send() for signal handlers, async-signal-safe; gives up instead of waiting when the
+     *        interrupted code was itself sending
+     * 
+     */
+    bool sendFromSignal(const char* frame, size_t length);
     #ifdef WIN32_PLATFORM
         LPVOID getData() const { return pBuf; }
     #else
@@ -51,20 +87,27 @@ public:
 class ServerUtil {
 private:
     SharedMemoryBuffer buffer;
+    // 只有接收线程关闭和重连;更换套接字时持有socket_mtx,心跳线程持锁发送,心跳超时只shutdown交给接收线程处理
     int server_socket;
+    std::mutex socket_mtx;
     unsigned short port;
+    // 先由waitForStartupConfirmation使用,之后归接收线程;与确认同一次读到的消息留给后者
+    framing::Decoder tcp_decoder;
 
     static const int MAX_MISSED_HEARTBEATS = 3;
-    int missed_heartbeat_count;
+    std::atomic<int> missed_heartbeat_count;
     bool heartbeat_alive;
-    std::time_t last_heartbeat_response;
+    std::atomic<std::time_t> last_heartbeat_response;
+
+    // 信号处理函数通过它找到当前实例
+    static ServerUtil* instance;
 
     /**
      * @brief send message to guardian by shared memory
      * 
-     * @param message message to be sent
+     * @param message e.g. control::STOPPED_REPLY
      */
-    void sendMessageToGuardian(const std::string& message);
+    void sendMessageToGuardian(const char* message);
 
     /**
      * @brief handle signal from terminal
@@ -82,7 +125,8 @@ private:
 
     /**
      * @brief startup heartbeat and send heartbeat message to guardian by socket
-     *        if the count of missed heartbeats reaches the maximum, reconnect to the port
+     *        if the count of missed heartbeats reaches the maximum, shut the connection down so that
+     *        receiveMessages() reconnects
      * 
      */
     void startHeartbeat();
@@ -95,6 +139,11 @@ private:
     void handleHeartbeatResponse(const json& j);
     void receiveMessages();
 
+    /**
+     * @brief close the connection to guardian under socket_mtx, server_socket becomes -1
+     */
+    void closeServerSocket();
+
 public:
     ServerUtil();
 
@@ -1,34 +1,20 @@
 #include "LogUtil/LogUtil.h"
+#include "LogUtil/RotatingLogHandler.h"
+#include "LogUtil/FlightRecorderLogHandler.h"
+#include "LogUtil/ShippingLogHandler.h"
 #include "ThreadPool/ThreadPool.h"
 #include "ServerUtil/ServerUtil.h"
 #include "ConfigUtil/ConfigUtil.h"
+#include "ConfigUtil/ConfigWatcher.h"
 
 #include <chrono>
 #include <iomanip>
 #include <sstream>
 
 
-// 生成包含当前日期的文件名
-std::string getCurrentDateTimeFilename() {
-    auto now = std::chrono::system_clock::now();
-    std::time_t now_c = std::chrono::system_clock::to_time_t(now);
-    std::tm now_tm;
-    localtime_r(&now_c, &now_tm);
-
-    std::ostringstream oss;
-    oss << std::put_time(&now_tm, "%Y_%m_%d") << ".log";
-    return oss.str();
-}
-
 int main(int argc, char* argv[]) {
     // 线程池和任务队列
 //     ThreadPool& thread_pool = ThreadPool::GetInstance(4);
-//     Logger& logger = Logger::GetInstance();
-//     auto terminalLogHandler = std::make_unique<TerminalLogHandler>();
-//     std::string logFileName = getCurrentDateTimeFilename();
-//     auto fileLogHandler = std::make_unique<FileLogHandler>(logFileName);
-//     logger.AddHandler(std::move(terminalLogHandler));
-//     logger.AddHandler(std::move(fileLogHandler));
 //     // 添加测试int返回值的任务
 //     std::future<int> r1 = thread_pool.submitTask(sum1, 10, 20);
 //     thread_pool.printStatus();
@@ -59,6 +45,44 @@ int main(int argc, char* argv[]) {
     // ConfigManager configer;
     // configer.readConfigByKey("/home/demo/Documents/Cpp_MultiServer/Server/config.conf", "DB", "port");
     srand(time(nullptr));
+
+    // 优先映射Guardian发布的共享内存配置,没有时自行读取配置文件;修改后无需重启即可生效,
+    // 两者都没有时使用ConfigKeys.h中的默认值
+    ConfigManager::setCommandLine(argc, argv);
+    ConfigWatcher config_watcher("config.conf", true);
+    config_watcher.start();
+    auto config = config_watcher.current();
+    if (!config) {
+        config = std::make_shared<const ConfigSnapshot>(ConfigSnapshot::ConfigMap());
+    }
+
+    Logger& logger = Logger::GetInstance();
+    logger.SetQueueCapacity(static_cast<size_t>(config->get(config_keys::LOG_QUEUE_CAPACITY)));
+    // 日志发送给Guardian合并写入;没有Guardian在收集时按日期/大小轮转写入 server_YYYY_MM_dd.<n>.log
+    logger.AddHandler(std::make_unique<ShippingLogHandler>(std::make_unique<RotatingFileLogHandler>("server")));
+    // 最近的日志同时写入共享内存环,进程崩溃后由Guardian转储
+    logger.AddHandler(std::make_unique<FlightRecorderLogHandler>(
+        static_cast<size_t>(config->get(config_keys::LOG_FLIGHT_RECORDER_SIZE))));
+
+    // 记录每个配置项的最终取值及来源,便于排查覆盖关系
+    std::istringstream resolved(config->describe());
+    for (std::string line; std::getline(resolved, line); ) {
+        logger.WriteLog("config " + line, DEBUG);
+    }
+
+    // [Log] level=DEBUG|INFO|WARN|ERROR 运行中修改立即生效
+    config_watcher.subscribe("Log", [&logger](const ConfigSnapshot& latest) {
+        LogLevel level;
+        const std::string& value = latest.get(config_keys::LOG_LEVEL);
+        if (LogLevelFromString(value, level)) {
+            // 先记录再切换,调高级别时这条通知不会被新级别过滤掉
+            logger.WriteLog("Log level set to " + LogLevelToString(level), INFO);
+            logger.SetLevel(level);
+        } else {
+            logger.WriteLog("Ignoring unknown log level '" + value + "'", WARN);
+        }
+    });
+
     try {
         ServerUtil server;
         server.start();
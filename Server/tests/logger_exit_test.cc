@@ -0,0 +1,75 @@
+/**
+ * @file logger_exit_test.cc
+ * @author KevinGlaser
+ * @brief Logging from a static destructor after exit() reaches the handlers
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * exit() destroys the main thread's thread_local objects before the static ones, so a static
+ * destructor that logs runs after the thread's staging buffer was retired. The record has to take
+ * the shared fallback path instead of touching the freed buffer. The handler prints the verdict
+ * when the Logger shuts down; ctest matches it.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "LogUtil/LogUtil.h"
+
+namespace {
+
+const std::string EXIT_MESSAGE = "logged from a static destructor";
+
+// 只统计退出阶段写入的记录,随Logger一起析构时输出结果
+class ExitCheckLogHandler : public LogHandler {
+public:
+    void HandleLog(const std::string&, LogLevel) override {}
+
+    void HandleBatch(const std::vector<LogRecord>& batch) override {
+        for (const auto& record : batch) {
+            if (record.body == EXIT_MESSAGE) {
+                ++delivered_;
+            }
+        }
+    }
+
+    bool NeedsFormattedText() const override { return false; }
+
+    ~ExitCheckLogHandler() override {
+        std::string verdict = "exit records delivered: " + std::to_string(delivered_) + "\n";
+        ssize_t written = write(STDOUT_FILENO, verdict.data(), verdict.size());
+        (void)written;
+    }
+
+private:
+    int delivered_ = 0;
+};
+
+// 在Logger之后构造,因此先于Logger析构
+struct ExitLogger {
+    ~ExitLogger() {
+        // 给日志线程时间注销本线程已作废的缓冲区,修复前这里写入的就是已释放的内存
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        Logger::GetInstance().WriteLog(EXIT_MESSAGE, INFO);
+    }
+};
+
+} // namespace
+
+int main() {
+    Logger& logger = Logger::GetInstance();
+    logger.AddHandler(std::make_unique<ExitCheckLogHandler>());
+
+    // 先让主线程建立自己的暂存缓冲区
+    logger.WriteLog("before exit", INFO);
+    static ExitLogger exit_logger;
+
+    exit(0);
+}
@@ -0,0 +1,288 @@
+/**
+ * @file logdecode.cc
+ * @author KevinGlaser
+ * @brief Offline decoder for segments written by BinaryLogHandler
+ * @version 0.1
+ * @date 2026-10-19
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ * usage: logdecode [--json] [--level LEVEL] [--from TIME] [--to TIME] segment.blog...
+ *        TIME is seconds since the epoch or "YYYY-MM-DD HH:MM:SS" in local time,
+ *        LEVEL is the lowest level printed (DEBUG, INFO, WARN, ERROR).
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "LogUtil/BinaryLogFormat.h"
+#include "JsonUtil/json.hpp"
+
+using json = nlohmann::json;
+
+// 未指定--level时的掩码
+constexpr uint32_t ALL_LEVELS = 0xffffffffu;
+
+struct DecodeOptions {
+    bool as_json = false;
+    uint32_t level_mask = ALL_LEVELS;
+    uint64_t from_ns = 0;
+    uint64_t to_ns = std::numeric_limits<uint64_t>::max();
+};
+
+// 只读映射整个文件,析构时解除映射
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) : data_(nullptr), size_(0) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1) {
+            return;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                data_ = static_cast<const char*>(addr);
+                size_ = static_cast<size_t>(st.st_size);
+                madvise(addr, size_, MADV_SEQUENTIAL);
+            }
+        }
+        close(fd);
+    }
+    ~MappedFile() {
+        if (data_ != nullptr) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_;
+    size_t size_;
+};
+
+static bool parseLevel(const std::string& name, uint32_t& mask) {
+    for (int level = DEBUG; level <= ERROR; ++level) {
+        if (LogLevelToString(static_cast<LogLevel>(level)) == name) {
+            // 指定级别及以上
+            mask = ~((1u << level) - 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parseTime(const std::string& text, uint64_t& ns) {
+    char* end = nullptr;
+    unsigned long long seconds = strtoull(text.c_str(), &end, 10);
+    if (end != text.c_str() && *end == '\0') {
+        ns = seconds * 1000000000ull;
+        return true;
+    }
+
+    std::tm tm{};
+    std::istringstream iss(text);
+    iss >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S");
+    if (iss.fail()) {
+        return false;
+    }
+    tm.tm_isdst = -1;
+    std::time_t t = std::mktime(&tm);
+    if (t == -1) {
+        return false;
+    }
+    ns = static_cast<uint64_t>(t) * 1000000000ull;
+    return true;
+}
+
+static std::string formatTimestamp(uint64_t ns) {
+    std::time_t seconds = static_cast<std::time_t>(ns / 1000000000ull);
+    std::tm tm;
+    localtime_r(&seconds, &tm);
+    char buffer[64];
+    size_t len = strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tm);
+    snprintf(buffer + len, sizeof(buffer) - len, ".%06llu",
+             static_cast<unsigned long long>((ns % 1000000000ull) / 1000));
+    return buffer;
+}
+
+static std::string levelName(uint8_t level) {
+    return level <= ERROR ? LogLevelToString(static_cast<LogLevel>(level)) : "UNKNOWN";
+}
+
+static void printRecord(const binlog::DecodedRecord& record, const DecodeOptions& options) {
+    if (options.as_json) {
+        json fields = json::object();
+        for (const auto& field : record.fields) {
+            std::string name(field.name);
+            switch (field.type) {
+                case binlog::FIELD_INT64: fields[name] = field.i64; break;
+                case binlog::FIELD_UINT64: fields[name] = field.u64; break;
+                case binlog::FIELD_DOUBLE: fields[name] = field.f64; break;
+                case binlog::FIELD_BOOL: fields[name] = field.boolean; break;
+                case binlog::FIELD_STRING: fields[name] = std::string(field.str); break;
+            }
+        }
+        json j = {
+            {"time", formatTimestamp(record.timestamp_ns)},
+            {"timestamp_ns", record.timestamp_ns},
+            {"level", levelName(record.level)},
+            {"thread", record.thread_id},
+            {"source", record.source_id},
+            {"message", std::string(record.message)},
+            {"fields", fields}
+        };
+        // 日志文本是任意字节,非UTF-8的部分替换为U+FFFD而不是抛异常
+        std::cout << j.dump(-1, ' ', false, json::error_handler_t::replace) << '\n';
+        return;
+    }
+
+    char source[16];
+    snprintf(source, sizeof(source), "%08x", record.source_id);
+    std::cout << formatTimestamp(record.timestamp_ns) << " [" << levelName(record.level) << "] "
+              << "thread:" << record.thread_id << " source:" << source << " message:" << record.message;
+    for (const auto& field : record.fields) {
+        std::cout << ' ' << field.name << '=';
+        switch (field.type) {
+            case binlog::FIELD_INT64: std::cout << field.i64; break;
+            case binlog::FIELD_UINT64: std::cout << field.u64; break;
+            case binlog::FIELD_DOUBLE: std::cout << field.f64; break;
+            case binlog::FIELD_BOOL: std::cout << (field.boolean ? "true" : "false"); break;
+            case binlog::FIELD_STRING: std::cout << field.str; break;
+        }
+    }
+    std::cout << '\n';
+}
+
+static bool matches(const binlog::DecodedRecord& record, const DecodeOptions& options) {
+    return record.timestamp_ns >= options.from_ns && record.timestamp_ns <= options.to_ns
+        // 级别来自磁盘,超出范围时不能移位:不过滤级别(未指定--level或--level DEBUG)时照常输出,否则无法判断,不输出
+        && (record.level <= ERROR ? (options.level_mask & (1u << record.level)) != 0
+                                  : options.level_mask == ALL_LEVELS);
+}
+
+static bool overlaps(uint64_t min_ns, uint64_t max_ns, uint32_t level_mask, const DecodeOptions& options) {
+    return max_ns >= options.from_ns && min_ns <= options.to_ns && (level_mask & options.level_mask) != 0;
+}
+
+/**
+ * @brief decode records in [p, end), at most limit of them
+ * @return offset just past the last record decoded
+ */
+static const char* decodeRange(const char* p, const char* end, uint64_t limit, const DecodeOptions& options) {
+    binlog::DecodedRecord record;
+    for (uint64_t n = 0; n < limit && p < end; ++n) {
+        size_t len = binlog::DecodeRecord(p, end, record);
+        if (len == 0) {
+            break;      // 崩溃时写了一半的记录
+        }
+        if (matches(record, options)) {
+            printRecord(record, options);
+        }
+        p += len;
+    }
+    return p;
+}
+
+static int decodeSegment(const std::string& path, const DecodeOptions& options) {
+    MappedFile segment(path);
+    const binlog::SegmentHeader* header = reinterpret_cast<const binlog::SegmentHeader*>(segment.data());
+    if (segment.data() == nullptr || segment.size() < sizeof(binlog::SegmentHeader)
+        || memcmp(header->magic, binlog::SEGMENT_MAGIC, sizeof(header->magic)) != 0
+        || header->version != binlog::FORMAT_VERSION) {
+        std::cerr << path << ": not a binary log segment" << std::endl;
+        return 1;
+    }
+    const char* begin = segment.data();
+    const char* end = begin + segment.size();
+
+    MappedFile index_file(path + ".idx");
+    const binlog::IndexHeader* index = reinterpret_cast<const binlog::IndexHeader*>(index_file.data());
+    bool indexed = index_file.data() != nullptr && index_file.size() >= sizeof(binlog::IndexHeader)
+        && memcmp(index->magic, binlog::INDEX_MAGIC, sizeof(index->magic)) == 0
+        && index_file.size() >= sizeof(binlog::IndexHeader) + index->entry_count * sizeof(binlog::IndexEntry);
+
+    if (!indexed) {
+        decodeRange(begin + header->header_size, end, std::numeric_limits<uint64_t>::max(), options);
+        return 0;
+    }
+
+    if (!overlaps(index->min_timestamp_ns, index->max_timestamp_ns, index->level_mask, options)) {
+        return 0;
+    }
+    const binlog::IndexEntry* entries = reinterpret_cast<const binlog::IndexEntry*>(index + 1);
+    for (uint64_t i = 0; i < index->entry_count; ++i) {
+        const binlog::IndexEntry& entry = entries[i];
+        if (entry.offset >= segment.size()
+            || !overlaps(entry.min_timestamp_ns, entry.max_timestamp_ns, entry.level_mask, options)) {
+            continue;
+        }
+        decodeRange(begin + entry.offset, end, entry.record_count, options);
+    }
+    return 0;
+}
+
+static void usage() {
+    std::cerr << "usage: logdecode [--json] [--level LEVEL] [--from TIME] [--to TIME] segment.blog...\n"
+              << "  TIME  seconds since the epoch or \"YYYY-MM-DD HH:MM:SS\" (local time)\n"
+              << "  LEVEL lowest level printed: DEBUG, INFO, WARN or ERROR" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    DecodeOptions options;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--json") {
+            options.as_json = true;
+        } else if (arg == "--level" && has_value) {
+            if (!parseLevel(argv[++i], options.level_mask)) {
+                std::cerr << "Unknown level: " << argv[i] << std::endl;
+                return 2;
+            }
+        } else if ((arg == "--from" || arg == "--to") && has_value) {
+            uint64_t& target = (arg == "--from") ? options.from_ns : options.to_ns;
+            if (!parseTime(argv[++i], target)) {
+                std::cerr << "Invalid time: " << argv[i] << std::endl;
+                return 2;
+            }
+            if (arg == "--to") {
+                target += 999999999ull;     // 包含该秒内的所有记录
+            }
+        } else if (arg == "-h" || arg == "--help" || arg.compare(0, 2, "--") == 0) {
+            usage();
+            return arg.compare(0, 2, "--") == 0 && arg != "--help" ? 2 : 0;
+        } else {
+            files.push_back(arg);
+        }
+    }
+
+    if (files.empty()) {
+        usage();
+        return 2;
+    }
+
+    std::ios::sync_with_stdio(false);
+    int status = 0;
+    for (const auto& file : files) {
+        status |= decodeSegment(file, options);
+    }
+    std::cout << std::flush;
+    return status;
+}